@@ -1,16 +1,17 @@
 #ifndef ALLOCATOR_H
 #define ALLOCATOR_H
 
-#include <list>
 #include <cstddef>
-#include "../core/block.h"
+#include <cstdint>
+#include "../core/free_index.h"
 
 class Allocator {
 public:
     virtual ~Allocator() = default;
 
-    virtual std::list<Block>::iterator
-    select_block(std::list<Block>& blocks, size_t size) = 0;
+    // block record to place `size` bytes in, or NO_BLOCK
+    virtual uint32_t
+    select_block(const FreeIndex& free_blocks, size_t size) = 0;
 };
 
 #endif
@@ -1,14 +1,7 @@
 #include "best_fit.h"
 
-std::list<Block>::iterator
-BestFitAllocator::select_block(std::list<Block>& blocks, size_t size) {
-    auto best = blocks.end();
-
-    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-        if (it->free && it->size >= size) {
-            if (best == blocks.end() || it->size < best->size)
-                best = it;
-        }
-    }
-    return best;
+// smallest free block with room, lowest address on ties
+uint32_t
+BestFitAllocator::select_block(const FreeIndex& free_blocks, size_t size) {
+    return free_blocks.best_fit(size);
 }
@@ -1,10 +1,7 @@
 #include "first_fit.h"
 
-std::list<Block>::iterator
-FirstFitAllocator::select_block(std::list<Block>& blocks, size_t size) {
-    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-        if (it->free && it->size >= size)
-            return it;
-    }
-    return blocks.end();
+// lowest-addressed free block with room
+uint32_t
+FirstFitAllocator::select_block(const FreeIndex& free_blocks, size_t size) {
+    return free_blocks.first_fit(size);
 }
@@ -5,8 +5,8 @@
 
 class FirstFitAllocator : public Allocator {
 public:
-    std::list<Block>::iterator
-    select_block(std::list<Block>& blocks, size_t size) override;
+    uint32_t
+    select_block(const FreeIndex& free_blocks, size_t size) override;
 };
 
 #endif
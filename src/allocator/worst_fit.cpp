@@ -1,14 +1,7 @@
 #include "worst_fit.h"
 
-std::list<Block>::iterator
-WorstFitAllocator::select_block(std::list<Block>& blocks, size_t size) {
-    auto worst = blocks.end();
-
-    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-        if (it->free && it->size >= size) {
-            if (worst == blocks.end() || it->size > worst->size)
-                worst = it;
-        }
-    }
-    return worst;
+// largest free block if it has room, lowest address on ties
+uint32_t
+WorstFitAllocator::select_block(const FreeIndex& free_blocks, size_t size) {
+    return free_blocks.worst_fit(size);
 }
@@ -0,0 +1,142 @@
+#include "locality.h"
+#include "../allocator/first_fit.h"
+#include "../allocator/best_fit.h"
+#include "../allocator/worst_fit.h"
+#include <algorithm>
+
+const char* policy_name(PlacementPolicy policy) {
+    switch (policy) {
+        case PlacementPolicy::FIRST_FIT: return "first_fit";
+        case PlacementPolicy::BEST_FIT:  return "best_fit";
+        case PlacementPolicy::WORST_FIT: return "worst_fit";
+        case PlacementPolicy::BUDDY:     return "buddy";
+    }
+    return "unknown";
+}
+
+TraceRunner::TraceRunner(PlacementPolicy p,
+                         size_t memory_size,
+                         const CacheConfig& config)
+    : policy(p), buddy_ok(false), cache(config),
+      accesses(0), dropped_accesses(0), failed_allocs(0)
+{
+    switch (policy) {
+        case PlacementPolicy::FIRST_FIT:
+            allocator.reset(new FirstFitAllocator());
+            break;
+        case PlacementPolicy::BEST_FIT:
+            allocator.reset(new BestFitAllocator());
+            break;
+        case PlacementPolicy::WORST_FIT:
+            allocator.reset(new WorstFitAllocator());
+            break;
+        case PlacementPolicy::BUDDY:
+            break;
+    }
+
+    if (policy == PlacementPolicy::BUDDY) {
+        buddy_ok = buddy.init(memory_size);
+    } else {
+        mem.init(memory_size);
+        mem.set_allocator(allocator.get());
+    }
+}
+
+void TraceRunner::apply(const TraceOp& op) {
+    if (op.type == TraceOpType::MALLOC) {
+        if (policy == PlacementPolicy::BUDDY) {
+            size_t addr = buddy_ok ? buddy.allocate(op.arg)
+                                   : BuddyAllocator::INVALID_ADDRESS;
+            if (addr == BuddyAllocator::INVALID_ADDRESS) {
+                failed_allocs++;
+                return;
+            }
+            live[op.id] = {addr, op.arg, INVALID_HANDLE};
+        } else {
+            Handle mem_id = mem.allocate(op.arg);
+            if (mem_id == INVALID_HANDLE) {
+                failed_allocs++;
+                return;
+            }
+            // placement never changes while the block is live, so the
+            // start address is looked up once here
+            size_t start = 0, size = 0;
+            mem.get_block(mem_id, start, size);
+            live[op.id] = {start, op.arg, mem_id};
+        }
+    }
+    else if (op.type == TraceOpType::FREE) {
+        auto it = live.find(op.id);
+        if (it == live.end())
+            return;
+
+        if (policy == PlacementPolicy::BUDDY)
+            buddy.deallocate(it->second.start, it->second.size);
+        else
+            mem.deallocate(it->second.mem_id);
+        live.erase(it);
+    }
+    else { // ACCESS
+        auto it = live.find(op.id);
+        if (it == live.end() || op.arg >= it->second.size) {
+            dropped_accesses++;
+            return;
+        }
+
+        cache.access(it->second.start + op.arg);
+        accesses++;
+    }
+}
+
+LocalityResult TraceRunner::result() const {
+    LocalityResult r;
+    r.policy = policy;
+    r.accesses = accesses;
+    r.dropped_accesses = dropped_accesses;
+    r.failed_allocs = failed_allocs;
+    for (size_t i = 0; i < cache.num_levels(); ++i) {
+        const Cache& level = cache.get_level(i);
+        size_t total = level.get_hits() + level.get_misses();
+        r.levels.push_back({cache.level_name(i), level.get_hits(), level.get_misses(),
+                            total == 0 ? 0.0 : (double)level.get_misses() / total});
+    }
+    r.memory_accesses = cache.get_memory_accesses();
+    r.memory_rate = accesses == 0 ? 0.0 : (double)r.memory_accesses / accesses;
+    r.fragmentation = policy == PlacementPolicy::BUDDY
+                          ? buddy.get_external_fragmentation()
+                          : mem.get_external_fragmentation();
+    return r;
+}
+
+std::vector<LocalityResult> analyze_locality(TraceSource& source,
+                                             size_t memory_size,
+                                             const CacheConfig& config) {
+    std::vector<PlacementPolicy> policies = {
+        PlacementPolicy::FIRST_FIT,
+        PlacementPolicy::BEST_FIT,
+        PlacementPolicy::WORST_FIT
+    };
+    if (memory_size > 0 && (memory_size & (memory_size - 1)) == 0)
+        policies.push_back(PlacementPolicy::BUDDY);
+
+    std::vector<LocalityResult> results;
+    for (PlacementPolicy policy : policies) {
+        TraceRunner runner(policy, memory_size, config);
+        TraceOp op;
+
+        source.rewind();
+        while (source.next(op))
+            runner.apply(op);
+        results.push_back(runner.result());
+    }
+
+    // fewest trips to memory first, then fewest (data) L1 misses
+    std::stable_sort(results.begin(), results.end(),
+                     [](const LocalityResult& a, const LocalityResult& b) {
+                         if (a.memory_rate != b.memory_rate)
+                             return a.memory_rate < b.memory_rate;
+                         return a.levels[0].miss_rate < b.levels[0].miss_rate;
+                     });
+
+    return results;
+}
@@ -0,0 +1,83 @@
+#ifndef LOCALITY_H
+#define LOCALITY_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include "../core/memory.h"
+#include "../allocator/allocator.h"
+#include "../buddy/buddy_allocator.h"
+#include "../cache/cache_system.h"
+#include "../trace/trace.h"
+
+enum class PlacementPolicy {
+    FIRST_FIT,
+    BEST_FIT,
+    WORST_FIT,
+    BUDDY
+};
+
+const char* policy_name(PlacementPolicy policy);
+
+struct LevelResult {
+    std::string name;
+    size_t hits;
+    size_t misses;
+    double miss_rate;         // local: misses / accesses reaching the level
+};
+
+struct LocalityResult {
+    PlacementPolicy policy;
+    size_t accesses;          // accesses that reached the cache
+    size_t dropped_accesses;  // unknown block or offset past its end
+    size_t failed_allocs;
+    std::vector<LevelResult> levels;   // in CacheConfig order
+    size_t memory_accesses;
+    double memory_rate;       // memory_accesses / accesses
+    double fragmentation;     // external fragmentation at end of trace
+};
+
+// replays a trace through one placement policy, translating (block id,
+// offset) accesses into physical addresses fed to a private CacheSystem
+class TraceRunner {
+private:
+    struct Placement {
+        size_t start;
+        size_t size;
+        Handle mem_id;
+    };
+
+    PlacementPolicy policy;
+    Memory mem;
+    std::unique_ptr<Allocator> allocator;
+    BuddyAllocator buddy;
+    bool buddy_ok;
+    CacheSystem cache;
+
+    // trace id -> placement
+    std::unordered_map<uint64_t, Placement> live;
+
+    size_t accesses;
+    size_t dropped_accesses;
+    size_t failed_allocs;
+
+public:
+    TraceRunner(PlacementPolicy policy,
+                size_t memory_size,
+                const CacheConfig& config);
+
+    void apply(const TraceOp& op);
+
+    LocalityResult result() const;
+};
+
+// run the trace under every policy that fits memory_size (buddy needs a
+// power of two), rewinding the source for each, and return the results
+// ranked best locality first
+std::vector<LocalityResult> analyze_locality(TraceSource& source,
+                                             size_t memory_size,
+                                             const CacheConfig& config);
+
+#endif
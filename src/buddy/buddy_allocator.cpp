@@ -1,4 +1,5 @@
 #include "buddy_allocator.h"
+#include "../perf/perf_counters.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -27,7 +28,9 @@ int order_from_size(size_t size) {
 } // anonymous namespace
 
 BuddyAllocator::BuddyAllocator()
-    : total_size(0), max_order(0) {}
+    : total_size(0), max_order(0),
+      lazy(false), lazy_threshold(0), coalesce_runs(0),
+      realloc_in_place(0), realloc_moved(0), bytes_moved(0) {}
 
 bool BuddyAllocator::init(size_t size) {
     if (!is_power_of_two(size)) {
@@ -40,11 +43,19 @@ bool BuddyAllocator::init(size_t size) {
 
     free_lists.clear();
     free_lists.resize(max_order + 1);
+    allocated.clear();
+
+    deferred_counts.assign(max_order + 1, 0);
+    coalesce_runs = 0;
+    realloc_in_place = 0;
+    realloc_moved = 0;
+    bytes_moved = 0;
 
     // one big free block initially
     BuddyBlock initial;
     initial.start = 0;
     initial.order = max_order;
+    initial.deferred = false;
 
     free_lists[max_order].push_back(initial);
 
@@ -61,16 +72,19 @@ void BuddyAllocator::dump() const {
             std::cout << "empty";
         } else {
             for (const auto& block : free_lists[k]) {
-                std::cout << "[" << block.start << "] ";
+                std::cout << "[" << block.start
+                          << (block.deferred ? "*" : "") << "] ";
             }
         }
         std::cout << "\n";
     }
 }
 
-long long BuddyAllocator::allocate(size_t size) {
+size_t BuddyAllocator::allocate(size_t size) {
+    PERF_TIME(PerfOp::BUDDY_MALLOC);
+
     if (size == 0 || size > total_size)
-        return -1;
+        return INVALID_ADDRESS;
 
     size_t req_size = size;
     size_t rounded = 1;
@@ -80,19 +94,27 @@ long long BuddyAllocator::allocate(size_t size) {
     while ((1ULL << req_order) < rounded) req_order++;
 
     // find smallest available block >= req_order
-    int curr_order = req_order;
-    while (curr_order <= max_order && free_lists[curr_order].empty()) {
-        curr_order++;
+    int curr_order = find_order(req_order);
+
+    // lazy mode: pending merges may be hiding a large enough block
+    if (curr_order < 0 && get_deferred_count() > 0) {
+        coalesce();
+        curr_order = find_order(req_order);
     }
 
-    if (curr_order > max_order) {
-        return -1; // no space
+    if (curr_order < 0) {
+        return INVALID_ADDRESS; // no space
     }
 
     // take a block from curr_order
     BuddyBlock block = free_lists[curr_order].front();
     free_lists[curr_order].pop_front();
 
+    if (block.deferred) {
+        deferred_counts[curr_order]--;
+        block.deferred = false;
+    }
+
     // split until we reach required order
     while (curr_order > req_order) {
         curr_order--;
@@ -100,20 +122,25 @@ long long BuddyAllocator::allocate(size_t size) {
         BuddyBlock buddy;
         buddy.start = block.start + (1ULL << curr_order);
         buddy.order = curr_order;
+        buddy.deferred = false;
 
         // left half stays in block
         block.order = curr_order;
 
         // right half goes to free list
         free_lists[curr_order].push_back(buddy);
+        PERF_COUNT(buddy_splits, 1);
     }
 
     // block is now of required size
-    return static_cast<long long>(block.start);
+    allocated.set(block.start, req_order);
+    return block.start;
 }
 
 bool BuddyAllocator::deallocate(size_t addr, size_t size) {
-    if (addr >= total_size || size == 0)
+    PERF_TIME(PerfOp::BUDDY_FREE);
+
+    if (addr >= total_size || size == 0 || size > total_size)
         return false;
 
     // round size up to power of two
@@ -123,6 +150,28 @@ bool BuddyAllocator::deallocate(size_t addr, size_t size) {
     int order = 0;
     while ((1ULL << order) < rounded) order++;
 
+    // a wrong address or size would corrupt the free lists
+    if (allocated.find(addr) != order)
+        return false;
+    allocated.erase(addr);
+
+    // lazy mode: park the block unmerged while this order has slack;
+    // front insertion lets the next same-sized request reuse it directly
+    if (lazy && deferred_counts[order] < lazy_threshold) {
+        BuddyBlock block;
+        block.start = addr;
+        block.order = order;
+        block.deferred = true;
+        free_lists[order].push_front(block);
+        deferred_counts[order]++;
+        return true;
+    }
+
+    merge_up(addr, order);
+    return true;
+}
+
+void BuddyAllocator::merge_up(size_t addr, int order) {
     size_t curr_addr = addr;
     int curr_order = order;
 
@@ -130,34 +179,239 @@ bool BuddyAllocator::deallocate(size_t addr, size_t size) {
     while (curr_order < max_order) {
         size_t buddy_addr = curr_addr ^ (1ULL << curr_order);
 
-        auto& free_list = free_lists[curr_order];
-        auto it = free_list.end();
-
-        // search for buddy
-        for (auto iter = free_list.begin(); iter != free_list.end(); ++iter) {
-            if (iter->start == buddy_addr) {
-                it = iter;
-                break;
-            }
-        }
-
-        if (it == free_list.end()) {
+        // remove buddy from its free list if it is there
+        if (!take_free(buddy_addr, curr_order)) {
             break; // buddy not free → stop merging
         }
 
-        // remove buddy from free list
-        free_list.erase(it);
-
         // merge blocks
         curr_addr = std::min(curr_addr, buddy_addr);
         curr_order++;
+        PERF_COUNT(buddy_merges, 1);
     }
 
     // insert merged block
     BuddyBlock block;
     block.start = curr_addr;
     block.order = curr_order;
+    block.deferred = false;
     free_lists[curr_order].push_back(block);
+}
 
-    return true;
+bool BuddyAllocator::take_free(size_t addr, int order) {
+    auto& free_list = free_lists[order];
+    for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+        PERF_COUNT(buddy_lookups, 1);
+        if (it->start == addr) {
+            if (it->deferred)
+                deferred_counts[order]--;
+            free_list.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t BuddyAllocator::reallocate(size_t addr, size_t old_size, size_t new_size) {
+    PERF_TIME(PerfOp::BUDDY_REALLOC);
+
+    if (addr >= total_size || old_size == 0 || old_size > total_size ||
+        new_size == 0 || new_size > total_size)
+        return INVALID_ADDRESS;
+
+    int old_order = order_from_size(old_size);
+    int new_order = order_from_size(new_size);
+
+    if (!is_allocated(addr, old_order))
+        return INVALID_ADDRESS;
+
+    // shrink: keep the lower half, return each upper half to its order
+    if (new_order <= old_order) {
+        for (int k = old_order - 1; k >= new_order; --k) {
+            BuddyBlock upper;
+            upper.start = addr + (1ULL << k);
+            upper.order = k;
+            upper.deferred = false;
+            free_lists[k].push_back(upper);
+        }
+        allocated.set(addr, new_order);
+        realloc_in_place++;
+        return addr;
+    }
+
+    // grow in place: addr must stay aligned to the new order and every
+    // upper buddy on the way up must be free as a whole block
+    bool in_place = (addr & ((1ULL << new_order) - 1)) == 0;
+    if (in_place) {
+        for (int k = old_order; k < new_order; ++k) {
+            size_t buddy_addr = addr + (1ULL << k);
+            bool found = false;
+            for (const auto& block : free_lists[k]) {
+                if (block.start == buddy_addr) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                in_place = false;
+                break;
+            }
+        }
+    }
+
+    if (in_place) {
+        for (int k = old_order; k < new_order; ++k)
+            take_free(addr + (1ULL << k), k);
+        allocated.set(addr, new_order);
+        realloc_in_place++;
+        return addr;
+    }
+
+    // relocate: the old block stays allocated until the copy is placed
+    size_t new_addr = allocate(new_size);
+    if (new_addr == INVALID_ADDRESS)
+        return INVALID_ADDRESS;
+
+    deallocate(addr, old_size);
+    bytes_moved += old_size;
+    realloc_moved++;
+
+    return new_addr;
+}
+
+bool BuddyAllocator::is_allocated(size_t addr, int order) const {
+    return allocated.find(addr) == order;
+}
+
+int BuddyAllocator::find_order(int req_order) const {
+    for (int k = req_order; k <= max_order; ++k) {
+        PERF_COUNT(order_searches, 1);
+        if (!free_lists[k].empty())
+            return k;
+    }
+    return -1;
+}
+
+void BuddyAllocator::set_lazy(bool enabled, size_t threshold) {
+    lazy = enabled;
+    lazy_threshold = enabled ? threshold : 0;
+
+    if (!enabled && get_deferred_count() > 0)
+        coalesce();
+}
+
+bool BuddyAllocator::is_lazy() const {
+    return lazy;
+}
+
+size_t BuddyAllocator::get_lazy_threshold() const {
+    return lazy_threshold;
+}
+
+void BuddyAllocator::coalesce() {
+    coalesce_runs++;
+
+    // bottom-up: pairs merged at order k may complete a pair at order k + 1
+    for (int k = 0; k < max_order; ++k) {
+        auto& free_list = free_lists[k];
+        size_t block_size = (1ULL << k);
+
+        free_list.sort([](const BuddyBlock& a, const BuddyBlock& b) {
+            return a.start < b.start;
+        });
+
+        auto it = free_list.begin();
+        while (it != free_list.end()) {
+            it->deferred = false;
+            auto next = std::next(it);
+
+            // a lower buddy immediately followed by its upper buddy
+            if (next != free_list.end() &&
+                (it->start & block_size) == 0 &&
+                next->start == it->start + block_size) {
+                BuddyBlock merged;
+                merged.start = it->start;
+                merged.order = k + 1;
+                merged.deferred = false;
+                free_lists[k + 1].push_back(merged);
+
+                free_list.erase(it);
+                it = free_list.erase(next);
+            } else {
+                it = next;
+            }
+        }
+        deferred_counts[k] = 0;
+    }
+
+    if (max_order >= 0 && !free_lists.empty()) {
+        for (auto& block : free_lists[max_order])
+            block.deferred = false;
+        deferred_counts[max_order] = 0;
+    }
+}
+
+size_t BuddyAllocator::get_total_memory() const {
+    return total_size;
+}
+
+size_t BuddyAllocator::get_free_memory() const {
+    size_t free_bytes = 0;
+    for (int k = 0; k <= max_order && k < (int)free_lists.size(); ++k)
+        free_bytes += free_lists[k].size() * (1ULL << k);
+    return free_bytes;
+}
+
+size_t BuddyAllocator::get_largest_free_block() const {
+    for (int k = (int)free_lists.size() - 1; k >= 0; --k) {
+        if (!free_lists[k].empty())
+            return 1ULL << k;
+    }
+    return 0;
+}
+
+size_t BuddyAllocator::get_free_block_count() const {
+    size_t count = 0;
+    for (const auto& free_list : free_lists)
+        count += free_list.size();
+    return count;
+}
+
+size_t BuddyAllocator::get_deferred_count() const {
+    size_t count = 0;
+    for (size_t c : deferred_counts)
+        count += c;
+    return count;
+}
+
+size_t BuddyAllocator::get_coalesce_runs() const {
+    return coalesce_runs;
+}
+
+size_t BuddyAllocator::get_realloc_in_place() const {
+    return realloc_in_place;
+}
+
+size_t BuddyAllocator::get_realloc_moved() const {
+    return realloc_moved;
+}
+
+size_t BuddyAllocator::get_bytes_moved() const {
+    return bytes_moved;
+}
+
+int BuddyAllocator::get_max_order() const {
+    return max_order;
+}
+
+size_t BuddyAllocator::get_free_list_length(int order) const {
+    if (order < 0 || order >= (int)free_lists.size())
+        return 0;
+    return free_lists[order].size();
+}
+
+double BuddyAllocator::get_external_fragmentation() const {
+    size_t total_free = get_free_memory();
+    if (total_free == 0) return 0.0;
+    return (1.0 - (double)get_largest_free_block() / total_free) * 100.0;
 }
@@ -4,7 +4,9 @@
 #include <vector>
 #include <list>
 #include <cstddef>
+#include <cstdint>
 #include "buddy_block.h"
+#include "live_block_table.h"
 
 class BuddyAllocator {
 private:
@@ -14,18 +16,79 @@ private:
     // free_lists[k] holds free blocks of size 2^k
     std::vector<std::list<BuddyBlock>> free_lists;
 
+    // live blocks, start -> order, so free/realloc can check ownership
+    // without walking the free lists
+    LiveBlockTable allocated;
+
+    // lazy coalescing: up to lazy_threshold blocks per order may sit in
+    // the free list without being merged with their buddy
+    bool lazy;
+    size_t lazy_threshold;
+    std::vector<size_t> deferred_counts;
+    size_t coalesce_runs;
+
+    // realloc cost accounting
+    size_t realloc_in_place;
+    size_t realloc_moved;
+    size_t bytes_moved;
+
+    // remove a whole free block of the given order, true if it was free
+    bool take_free(size_t addr, int order);
+
+    // merge a freed block upward with any free buddies and insert it
+    void merge_up(size_t addr, int order);
+
+    // find the smallest order >= req_order with a free block, or -1
+    int find_order(int req_order) const;
+
+    // true if a live allocation of exactly this order starts at addr
+    bool is_allocated(size_t addr, int order) const;
+
 public:
+    // returned by allocate/reallocate on failure
+    static const size_t INVALID_ADDRESS = SIZE_MAX;
+
     BuddyAllocator();
 
     // initialize memory (size must be power of two)
     bool init(size_t size);
 
-    // allocate memory, returns starting address or -1 on failure
-    long long allocate(size_t size);
+    // switch between eager (merge on every free) and lazy coalescing;
+    // turning lazy mode off merges all pending blocks immediately
+    void set_lazy(bool enabled, size_t threshold);
+    bool is_lazy() const;
+    size_t get_lazy_threshold() const;
+
+    // merge every pending buddy pair across all orders
+    void coalesce();
 
-    // free memory given address and size
+    // allocate memory, returns starting address or INVALID_ADDRESS
+    size_t allocate(size_t size);
+
+    // free memory given address and size; false if that is not an
+    // allocated block of the size's order
     bool deallocate(size_t addr, size_t size);
 
+    // resize the block at addr; shrinks by releasing upper halves and
+    // grows by absorbing free upper buddies, relocating only when neither
+    // works. returns the (possibly new) address, or INVALID_ADDRESS if
+    // there is no room or addr/old_size is not an allocated block
+    size_t reallocate(size_t addr, size_t old_size, size_t new_size);
+
+    // statistics
+    size_t get_total_memory() const;
+    size_t get_free_memory() const;
+    size_t get_largest_free_block() const;
+    size_t get_free_block_count() const;
+    size_t get_deferred_count() const;
+    size_t get_coalesce_runs() const;
+    size_t get_realloc_in_place() const;
+    size_t get_realloc_moved() const;
+    size_t get_bytes_moved() const;
+    int get_max_order() const;
+    size_t get_free_list_length(int order) const;
+    double get_external_fragmentation() const;
+
     // debugging / visualization
     void dump() const;
 };
@@ -0,0 +1,71 @@
+#include "buddy_bench.h"
+#include "buddy_allocator.h"
+#include <chrono>
+#include <random>
+#include <vector>
+#include <utility>
+
+BuddyBenchResult run_buddy_churn(ChurnTrace trace,
+                                 size_t memory_size,
+                                 size_t ops,
+                                 size_t threshold,
+                                 unsigned seed) {
+    BuddyBenchResult result = {0, 0, 0.0, 0.0, 0.0, 0, 0};
+
+    BuddyAllocator buddy;
+    if (!buddy.init(memory_size))
+        return result;
+    if (threshold > 0)
+        buddy.set_lazy(true, threshold);
+
+    std::mt19937 rng(seed);
+
+    // keep the live set well below capacity so failures stay rare
+    size_t max_size = memory_size / 64 > 0 ? memory_size / 64 : 1;
+    size_t max_live = 16;
+    size_t fixed_size = max_size / 2 > 0 ? max_size / 2 : 1;
+
+    std::uniform_int_distribution<size_t> size_dist(1, max_size);
+    std::uniform_int_distribution<int> coin(0, 1);
+
+    // live allocations: (addr, size)
+    std::vector<std::pair<size_t, size_t>> live;
+    live.reserve(max_live);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < ops; ++i) {
+        bool do_alloc = live.empty() ||
+                        (live.size() < max_live && coin(rng) == 1);
+
+        if (do_alloc) {
+            size_t size = (trace == ChurnTrace::SAME_SIZE)
+                              ? fixed_size
+                              : size_dist(rng);
+            size_t addr = buddy.allocate(size);
+            if (addr == BuddyAllocator::INVALID_ADDRESS)
+                result.failures++;
+            else
+                live.push_back({addr, size});
+        } else {
+            size_t idx = live.size() - 1;
+            if (trace == ChurnTrace::MIXED)
+                idx = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+
+            buddy.deallocate(live[idx].first, live[idx].second);
+            live[idx] = live.back();
+            live.pop_back();
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    result.ops = ops;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.ops_per_sec = result.seconds > 0 ? ops / result.seconds : 0.0;
+    result.fragmentation = buddy.get_external_fragmentation();
+    result.free_blocks = buddy.get_free_block_count();
+    result.coalesce_runs = buddy.get_coalesce_runs();
+
+    return result;
+}
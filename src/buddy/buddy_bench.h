@@ -0,0 +1,30 @@
+#ifndef BUDDY_BENCH_H
+#define BUDDY_BENCH_H
+
+#include <cstddef>
+
+// churn traces used to compare eager and lazy buddy coalescing
+enum class ChurnTrace {
+    SAME_SIZE,   // repeated malloc/free of one size, LIFO frees
+    MIXED        // random sizes, random frees, bounded live set
+};
+
+struct BuddyBenchResult {
+    size_t ops;
+    size_t failures;
+    double seconds;
+    double ops_per_sec;
+    double fragmentation;     // external fragmentation at end of trace
+    size_t free_blocks;       // free list entries at end of trace
+    size_t coalesce_runs;
+};
+
+// replay a deterministic churn trace on a fresh allocator of memory_size
+// bytes; threshold == 0 selects eager coalescing
+BuddyBenchResult run_buddy_churn(ChurnTrace trace,
+                                 size_t memory_size,
+                                 size_t ops,
+                                 size_t threshold,
+                                 unsigned seed);
+
+#endif
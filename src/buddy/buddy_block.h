@@ -6,6 +6,7 @@
 struct BuddyBlock {
     size_t start;   // starting address
     int order;      // block size = 2^order
+    bool deferred;  // freed lazily, merge with buddy still pending
 };
 
 #endif
@@ -0,0 +1,99 @@
+#ifndef LIVE_BLOCK_TABLE_H
+#define LIVE_BLOCK_TABLE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Start address -> order of every live buddy block. Open addressing with
+// linear probing and backward-shift deletion: no tombstones and no heap
+// allocation per insert/erase, so ownership checks stay O(1) on the
+// lazy free path. Load is kept at or below one half.
+class LiveBlockTable {
+private:
+    struct Entry {
+        size_t addr;
+        int order;      // -1: empty
+    };
+
+    std::vector<Entry> entries;     // size is a power of two
+    size_t count;
+
+    static const size_t MIN_CAPACITY = 64;
+
+    size_t home_of(size_t addr) const {
+        uint64_t h = static_cast<uint64_t>(addr) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(h ^ (h >> 32)) & (entries.size() - 1);
+    }
+
+    // slot holding addr, or the empty slot where it would go
+    size_t probe(size_t addr) const {
+        size_t mask = entries.size() - 1;
+        size_t i = home_of(addr);
+        while (entries[i].order >= 0 && entries[i].addr != addr)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        std::vector<Entry> old;
+        old.swap(entries);
+        entries.assign(old.size() * 2, Entry{0, -1});
+        for (const auto& e : old) {
+            if (e.order >= 0)
+                entries[probe(e.addr)] = e;
+        }
+    }
+
+public:
+    LiveBlockTable() : entries(MIN_CAPACITY, Entry{0, -1}), count(0) {}
+
+    void clear() {
+        entries.assign(MIN_CAPACITY, Entry{0, -1});
+        count = 0;
+    }
+
+    // order of the live block at addr, or -1
+    int find(size_t addr) const {
+        return entries[probe(addr)].order;
+    }
+
+    // add addr or change its order
+    void set(size_t addr, int order) {
+        size_t i = probe(addr);
+        if (entries[i].order < 0) {
+            if ((count + 1) * 2 > entries.size()) {
+                grow();
+                i = probe(addr);
+            }
+            count++;
+        }
+        entries[i] = Entry{addr, order};
+    }
+
+    // true if addr was live
+    bool erase(size_t addr) {
+        size_t mask = entries.size() - 1;
+        size_t hole = probe(addr);
+        if (entries[hole].order < 0)
+            return false;
+
+        // pull later entries of the run back unless that would move one
+        // before its home slot
+        for (size_t j = (hole + 1) & mask; entries[j].order >= 0; j = (j + 1) & mask) {
+            size_t home = home_of(entries[j].addr);
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                entries[hole] = entries[j];
+                hole = j;
+            }
+        }
+
+        entries[hole].order = -1;
+        count--;
+        return true;
+    }
+
+    size_t size() const { return count; }
+};
+
+#endif
@@ -6,7 +6,15 @@ Cache::Cache(size_t csize, size_t bsize, int assoc)
       block_size(bsize),
       associativity(assoc),
       hits(0),
-      misses(0)
+      misses(0),
+      fills(0),
+      invalidations(0),
+      buffer_hits(0),
+      prefetch_lookups(0),
+      prefetch_lookup_misses(0),
+      track_evictions(false),
+      prefetch_latency(0),
+      tick(0)
 {
     num_sets = cache_size / (block_size * associativity);
     sets.reserve(num_sets);
@@ -14,7 +22,36 @@ Cache::Cache(size_t csize, size_t bsize, int assoc)
         sets.emplace_back(associativity);
 }
 
+CacheLine* Cache::find_line(CacheSet& set, size_t tag) {
+    for (auto& line : set.lines) {
+        if (line.valid && line.tag == tag)
+            return &line;
+    }
+    return nullptr;
+}
+
+CacheLine& Cache::replace(CacheSet& set, size_t set_index) {
+    for (auto& line : set.lines) {
+        if (!line.valid)
+            return line;
+    }
+
+    CacheLine& victim = set.lines[set.fifo_ptr];
+    set.fifo_ptr = (set.fifo_ptr + 1) % associativity;
+
+    if (track_evictions)
+        evictions.push_back((victim.tag * num_sets + set_index) * block_size);
+    if (victim.prefetched)
+        prefetcher->get_stats().polluting++;
+    return victim;
+}
+
 bool Cache::access(size_t address) {
+    if (track_evictions)
+        evictions.clear();
+    if (prefetcher)
+        return access_with_prefetch(address);
+
     size_t block_addr = address / block_size;
     size_t set_index = block_addr % num_sets;
     size_t tag = block_addr / num_sets;
@@ -22,31 +59,242 @@ bool Cache::access(size_t address) {
     CacheSet& set = sets[set_index];
 
     // check hit
-    for (auto& line : set.lines) {
-        if (line.valid && line.tag == tag) {
-            hits++;
-            return true;
-        }
+    if (find_line(set, tag)) {
+        hits++;
+        return true;
     }
 
     // miss → FIFO replace
     misses++;
 
-    CacheLine& victim = set.lines[set.fifo_ptr];
+    CacheLine& victim = replace(set, set_index);
     victim.valid = true;
     victim.tag = tag;
 
-    set.fifo_ptr = (set.fifo_ptr + 1) % associativity;
+    return false;
+}
+
+bool Cache::access_with_prefetch(size_t address) {
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheSet& set = sets[set_index];
+    PrefetchStats& pstats = prefetcher->get_stats();
+    tick++;
+
+    bool hit = false;
+    bool prefetch_hit = false;
+    bool claimed = false;
+
+    std::vector<size_t>& requests = prefetcher->get_requests();
+    requests.clear();
+
+    CacheLine* line = find_line(set, tag);
+    if (line) {
+        hit = true;
+        if (line->prefetched) {
+            line->prefetched = false;
+            prefetch_hit = true;
+            if (tick < line->ready_at)
+                pstats.late++;
+            else
+                pstats.useful++;
+        }
+    } else {
+        // a stream buffer can supply the block instead of the next level
+        if (prefetcher->claim(block_addr, tick)) {
+            hit = true;
+            prefetch_hit = true;
+            claimed = true;
+        }
+
+        CacheLine& victim = replace(set, set_index);
+        victim.valid = true;
+        victim.prefetched = false;
+        victim.tag = tag;
+    }
+
+    // a claimed block was still a cache miss; it just never reaches the
+    // next level as a demand request
+    if (hit && !claimed)
+        hits++;
+    else
+        misses++;
+    if (claimed)
+        buffer_hits++;
+
+    prefetch_fills.clear();
+    prefetcher->on_access(block_addr, hit, prefetch_hit, tick, prefetch_fills);
+    for (size_t fill : prefetch_fills)
+        prefetch_fill(fill);
+
+    prefetch_requests.clear();
+    for (size_t block : requests)
+        prefetch_requests.push_back(block * block_size);
+
+    return hit;
+}
+
+void Cache::prefetch_fill(size_t block_addr) {
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheSet& set = sets[set_index];
+    if (find_line(set, tag))
+        return;
+
+    prefetcher->issue(block_addr);
+
+    CacheLine& victim = replace(set, set_index);
+    victim.valid = true;
+    victim.prefetched = true;
+    victim.tag = tag;
+    victim.ready_at = tick + prefetch_latency;
+}
+
+bool Cache::take(size_t address) {
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheLine* line = find_line(sets[set_index], tag);
+    if (!line) {
+        misses++;
+        return false;
+    }
+
+    if (line->prefetched)
+        prefetcher->get_stats().useful++;
+    line->valid = false;
+    line->prefetched = false;
+    hits++;
+    return true;
+}
+
+void Cache::fill(size_t address) {
+    if (track_evictions)
+        evictions.clear();
 
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheSet& set = sets[set_index];
+    if (find_line(set, tag))
+        return;
+
+    fills++;
+
+    CacheLine& victim = replace(set, set_index);
+    victim.valid = true;
+    victim.prefetched = false;
+    victim.tag = tag;
+}
+
+bool Cache::prefetch_lookup(size_t address, bool take) {
+    if (track_evictions)
+        evictions.clear();
+
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheSet& set = sets[set_index];
+    prefetch_lookups++;
+
+    CacheLine* line = find_line(set, tag);
+    if (line) {
+        if (take) {
+            line->valid = false;
+            line->prefetched = false;
+        }
+        return true;
+    }
+
+    prefetch_lookup_misses++;
+    if (take)
+        return false;
+
+    CacheLine& victim = replace(set, set_index);
+    victim.valid = true;
+    victim.prefetched = false;
+    victim.tag = tag;
+    return false;
+}
+
+bool Cache::contains(size_t address) const {
+    size_t block_addr = address / block_size;
+    size_t tag = block_addr / num_sets;
+
+    for (const auto& line : sets[block_addr % num_sets].lines) {
+        if (line.valid && line.tag == tag)
+            return true;
+    }
     return false;
 }
 
+bool Cache::invalidate(size_t address) {
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+
+    CacheLine* line = find_line(sets[set_index], tag);
+    if (!line)
+        return false;
+
+    if (line->prefetched)
+        prefetcher->get_stats().polluting++;
+    line->valid = false;
+    line->prefetched = false;
+    invalidations++;
+    return true;
+}
+
+void Cache::set_eviction_tracking(bool on) {
+    track_evictions = on;
+    evictions.clear();
+}
+
+const std::vector<size_t>& Cache::get_evictions() const {
+    return evictions;
+}
+
+const std::vector<size_t>& Cache::get_prefetch_requests() const {
+    return prefetch_requests;
+}
+
+void Cache::set_prefetcher(std::unique_ptr<Prefetcher> p, int latency) {
+    prefetcher = std::move(p);
+    prefetch_latency = latency;
+    prefetch_requests.clear();
+
+    for (auto& set : sets)
+        for (auto& line : set.lines)
+            line.prefetched = false;
+}
+
+const Prefetcher* Cache::get_prefetcher() const {
+    return prefetcher.get();
+}
+
 void Cache::reset_stats() {
     hits = misses = 0;
+    fills = invalidations = 0;
+    buffer_hits = 0;
+    prefetch_lookups = prefetch_lookup_misses = 0;
+    if (prefetcher)
+        prefetcher->reset_stats();
 }
 
 size_t Cache::get_hits() const { return hits; }
 size_t Cache::get_misses() const { return misses; }
+size_t Cache::get_fills() const { return fills; }
+size_t Cache::get_invalidations() const { return invalidations; }
+size_t Cache::get_buffer_hits() const { return buffer_hits; }
+size_t Cache::get_prefetch_lookups() const { return prefetch_lookups; }
+size_t Cache::get_prefetch_lookup_misses() const { return prefetch_lookup_misses; }
+size_t Cache::get_block_size() const { return block_size; }
 
 double Cache::hit_ratio() const {
     size_t total = hits + misses;
@@ -58,4 +306,25 @@ void Cache::dump(const std::string& name) const {
     std::cout << "Hits: " << hits << "\n";
     std::cout << "Misses: " << misses << "\n";
     std::cout << "Hit ratio: " << hit_ratio() * 100 << "%\n";
+
+    if (fills > 0 || invalidations > 0) {
+        std::cout << "Victim fills: " << fills
+                  << ", back-invalidations: " << invalidations << "\n";
+    }
+
+    if (prefetcher) {
+        const PrefetchStats& p = prefetcher->get_stats();
+        std::cout << "Prefetcher: " << prefetcher->name() << "\n";
+        std::cout << "Prefetches issued: " << p.issued
+                  << ", useful: " << p.useful
+                  << ", late: " << p.late
+                  << ", polluting: " << p.polluting << "\n";
+        if (buffer_hits > 0)
+            std::cout << "Stream buffer hits (counted as misses): " << buffer_hits << "\n";
+    }
+
+    if (prefetch_lookups > 0) {
+        std::cout << "Prefetch requests from above: " << prefetch_lookups
+                  << ", missed: " << prefetch_lookup_misses << "\n";
+    }
 }
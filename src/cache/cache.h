@@ -4,7 +4,10 @@
 #include <vector>
 #include <cstddef>
 #include <string>
+#include <memory>
+#include <cstdint>
 #include "cache_set.h"
+#include "prefetcher.h"
 
 class Cache {
 private:
@@ -18,6 +21,30 @@ private:
     // stats
     size_t hits;
     size_t misses;
+    size_t fills;           // blocks installed by fill()
+    size_t invalidations;   // blocks removed by invalidate()
+    size_t buffer_hits;     // misses a stream buffer supplied
+    size_t prefetch_lookups;        // prefetch requests from the level above
+    size_t prefetch_lookup_misses;
+
+    // eviction reporting for the hierarchy's inclusion policy
+    bool track_evictions;
+    std::vector<size_t> evictions;
+
+    // prefetching (off unless a prefetcher is attached)
+    std::unique_ptr<Prefetcher> prefetcher;
+    int prefetch_latency;
+    uint64_t tick;
+    std::vector<size_t> prefetch_fills;
+    std::vector<size_t> prefetch_requests;
+
+    bool access_with_prefetch(size_t address);
+    void prefetch_fill(size_t block_addr);
+
+    CacheLine* find_line(CacheSet& set, size_t tag);
+
+    // an invalid line if the set has one, else the FIFO victim
+    CacheLine& replace(CacheSet& set, size_t set_index);
 
 public:
     Cache(size_t cache_size,
@@ -25,10 +52,47 @@ public:
           int associativity);
 
     bool access(size_t address);   // true = hit, false = miss
+
+    // hit/miss like access(), but a hit removes the block (it moves to
+    // an upper level) and a miss does not fill
+    bool take(size_t address);
+
+    // install a block without counting an access; no-op if present
+    void fill(size_t address);
+
+    // presence check without touching stats or replacement state
+    bool contains(size_t address) const;
+
+    // remove a block if present; true if it was
+    bool invalidate(size_t address);
+
+    // when on, access()/fill() record the addresses of valid blocks they
+    // evict, readable until the next access()/fill()
+    void set_eviction_tracking(bool on);
+    const std::vector<size_t>& get_evictions() const;
+
+    // addresses the last access()'s prefetches fetch from the next level
+    const std::vector<size_t>& get_prefetch_requests() const;
+
+    // a prefetch request from the level above, counted apart from demand
+    // hits and misses. a miss installs the block; with `take` a hit
+    // removes it instead and a miss installs nothing (exclusive)
+    bool prefetch_lookup(size_t address, bool take);
+
     void reset_stats();
 
+    // replaces any attached prefetcher; nullptr turns prefetching off
+    void set_prefetcher(std::unique_ptr<Prefetcher> p, int latency);
+    const Prefetcher* get_prefetcher() const;
+
     size_t get_hits() const;
     size_t get_misses() const;
+    size_t get_fills() const;
+    size_t get_invalidations() const;
+    size_t get_buffer_hits() const;
+    size_t get_prefetch_lookups() const;
+    size_t get_prefetch_lookup_misses() const;
+    size_t get_block_size() const;
     double hit_ratio() const;
 
     void dump(const std::string& name) const;
@@ -0,0 +1,168 @@
+#include "cache_config.h"
+#include <sstream>
+#include <cctype>
+
+namespace {
+
+bool parse_level(const std::string& spec, CacheLevelConfig& level) {
+    std::string rest = spec;
+
+    level.name.clear();
+    if (!rest.empty() && !std::isdigit(static_cast<unsigned char>(rest[0]))) {
+        size_t colon = rest.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return false;
+        level.name = rest.substr(0, colon);
+        rest = rest.substr(colon + 1);
+    }
+
+    std::stringstream ss(rest);
+    char sep1 = 0, sep2 = 0;
+    if (!(ss >> level.size >> sep1 >> level.block_size >> sep2 >> level.associativity))
+        return false;
+    if (sep1 != ':' || sep2 != ':')
+        return false;
+
+    level.prefetch = default_prefetch_config();
+    if (!ss.eof()) {
+        std::string prefetch;
+        if (ss.get() != ':' || !(ss >> prefetch) ||
+            !parse_prefetch_config(prefetch, level.prefetch))
+            return false;
+    }
+    return is_valid_level(level);
+}
+
+std::string depth_name(size_t depth) {
+    return "L" + std::to_string(depth);
+}
+
+// depth of each level, counting a split L1 pair as one
+size_t level_depth(const CacheConfig& config, size_t index) {
+    if (has_split_l1(config))
+        return index < 2 ? 1 : index;
+    return index + 1;
+}
+
+void format_level(std::stringstream& ss, const CacheConfig& config, size_t index) {
+    const CacheLevelConfig& level = config.levels[index];
+    if (!same_level_name(level.name, depth_name(level_depth(config, index))))
+        ss << level.name << ":";
+    ss << level.size << ":" << level.block_size << ":" << level.associativity;
+    if (level.prefetch.kind != PrefetchKind::NONE)
+        ss << ":" << format_prefetch_config(level.prefetch);
+}
+
+} // anonymous namespace
+
+const char* inclusion_name(InclusionPolicy policy) {
+    switch (policy) {
+        case InclusionPolicy::NINE:      return "nine";
+        case InclusionPolicy::INCLUSIVE: return "inclusive";
+        case InclusionPolicy::EXCLUSIVE: return "exclusive";
+    }
+    return "unknown";
+}
+
+CacheConfig default_cache_config() {
+    CacheConfig config;
+    config.levels.push_back({"L1", 32768, 64, 8});
+    config.levels.push_back({"L2", 262144, 64, 8});
+    return config;
+}
+
+bool same_level_name(const std::string& a, const std::string& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::toupper(static_cast<unsigned char>(a[i])) !=
+            std::toupper(static_cast<unsigned char>(b[i])))
+            return false;
+    return true;
+}
+
+bool has_split_l1(const CacheConfig& config) {
+    return config.levels.size() >= 2 &&
+           same_level_name(config.levels[0].name, "L1D") &&
+           same_level_name(config.levels[1].name, "L1I");
+}
+
+size_t first_shared_level(const CacheConfig& config) {
+    return has_split_l1(config) ? 2 : 1;
+}
+
+bool is_valid_level(const CacheLevelConfig& level) {
+    // size / assoc rather than block * assoc, which can overflow
+    return level.block_size > 0 && level.associativity > 0 &&
+           level.block_size <= level.size / static_cast<size_t>(level.associativity);
+}
+
+bool is_valid_config(const CacheConfig& config) {
+    if (config.levels.empty())
+        return false;
+
+    for (size_t i = 0; i < config.levels.size(); ++i) {
+        const CacheLevelConfig& level = config.levels[i];
+        if (!is_valid_level(level) || level.name.empty())
+            return false;
+        for (size_t j = 0; j < i; ++j)
+            if (same_level_name(config.levels[j].name, level.name))
+                return false;
+
+        // back-invalidation and victim fill move whole blocks between levels
+        if (config.policy != InclusionPolicy::NINE &&
+            level.block_size != config.levels[0].block_size)
+            return false;
+    }
+    return true;
+}
+
+bool parse_cache_config(const std::string& spec, CacheConfig& config) {
+    CacheConfig parsed;
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, '/')) {
+        if (item.compare(0, 7, "policy=") == 0) {
+            std::string value = item.substr(7);
+            if (value == "nine") parsed.policy = InclusionPolicy::NINE;
+            else if (value == "inclusive") parsed.policy = InclusionPolicy::INCLUSIVE;
+            else if (value == "exclusive") parsed.policy = InclusionPolicy::EXCLUSIVE;
+            else return false;
+            continue;
+        }
+
+        CacheLevelConfig level;
+        if (!parse_level(item, level))
+            return false;
+        parsed.levels.push_back(level);
+    }
+
+    // L1I before L1D is accepted, but stored data side first
+    if (parsed.levels.size() >= 2 &&
+        same_level_name(parsed.levels[0].name, "L1I") &&
+        same_level_name(parsed.levels[1].name, "L1D"))
+        std::swap(parsed.levels[0], parsed.levels[1]);
+
+    for (size_t i = 0; i < parsed.levels.size(); ++i)
+        if (parsed.levels[i].name.empty())
+            parsed.levels[i].name = depth_name(level_depth(parsed, i));
+
+    if (!is_valid_config(parsed))
+        return false;
+
+    config = parsed;
+    return true;
+}
+
+std::string format_cache_config(const CacheConfig& config) {
+    std::stringstream ss;
+    for (size_t i = 0; i < config.levels.size(); ++i) {
+        if (i > 0)
+            ss << "/";
+        format_level(ss, config, i);
+    }
+    if (config.policy != InclusionPolicy::NINE)
+        ss << "/policy=" << inclusion_name(config.policy);
+    return ss.str();
+}
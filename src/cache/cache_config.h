@@ -0,0 +1,57 @@
+#ifndef CACHE_CONFIG_H
+#define CACHE_CONFIG_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "prefetcher.h"
+
+enum class InclusionPolicy {
+    NINE,        // non-inclusive non-exclusive: every level fills on a miss
+    INCLUSIVE,   // lower levels hold everything above; evictions back-invalidate
+    EXCLUSIVE    // a block lives in one level; L1 victims fill the next level
+};
+
+const char* inclusion_name(InclusionPolicy policy);
+
+struct CacheLevelConfig {
+    std::string name;
+    size_t size;
+    size_t block_size;
+    int associativity;
+    PrefetchConfig prefetch = default_prefetch_config();
+};
+
+// levels are ordered closest to the core first. a split L1 is written
+// as L1D followed by L1I; every later level is shared by both
+struct CacheConfig {
+    std::vector<CacheLevelConfig> levels;
+    InclusionPolicy policy = InclusionPolicy::NINE;
+};
+
+// 32 KiB/64 B/8-way L1, 256 KiB/64 B/8-way L2, NINE
+CacheConfig default_cache_config();
+
+// level names compare case-insensitively ("l1d" is L1D)
+bool same_level_name(const std::string& a, const std::string& b);
+
+bool has_split_l1(const CacheConfig& config);
+
+// index of the first level shared by instruction and data accesses
+size_t first_shared_level(const CacheConfig& config);
+
+// a level must hold at least one set of `associativity` blocks
+bool is_valid_level(const CacheLevelConfig& level);
+
+// at least one valid level, unique names, and a single block size under
+// the inclusive and exclusive policies
+bool is_valid_config(const CacheConfig& config);
+
+// levels separated by '/', each "[name:]size:block:assoc[:prefetch]",
+// optionally ending in "/policy=nine|inclusive|exclusive". prefetch is a
+// parse_prefetch_config spec such as "stride:degree=4". unnamed levels
+// are called L1, L2, ... by depth
+bool parse_cache_config(const std::string& spec, CacheConfig& config);
+std::string format_cache_config(const CacheConfig& config);
+
+#endif
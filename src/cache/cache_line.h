@@ -2,12 +2,15 @@
 #define CACHE_LINE_H
 
 #include <cstddef>
+#include <cstdint>
 
 struct CacheLine {
     bool valid;
+    bool prefetched;     // filled by a prefetch and not yet demanded
     size_t tag;
+    uint64_t ready_at;   // access count at which a prefetch completes
 
-    CacheLine() : valid(false), tag(0) {}
+    CacheLine() : valid(false), prefetched(false), tag(0), ready_at(0) {}
 };
 
 #endif
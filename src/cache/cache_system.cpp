@@ -1,31 +1,199 @@
 #include "cache_system.h"
 #include <iostream>
 
+namespace {
+
+CacheConfig two_level_config(size_t l1_size, size_t l1_block, int l1_assoc,
+                             size_t l2_size, size_t l2_block, int l2_assoc) {
+    CacheConfig config;
+    config.levels.push_back({"L1", l1_size, l1_block, l1_assoc});
+    config.levels.push_back({"L2", l2_size, l2_block, l2_assoc});
+    return config;
+}
+
+} // anonymous namespace
+
 CacheSystem::CacheSystem(size_t l1_size, size_t l1_block, int l1_assoc,
                          size_t l2_size, size_t l2_block, int l2_assoc)
-    : l1(l1_size, l1_block, l1_assoc),
-      l2(l2_size, l2_block, l2_assoc),
-      memory_accesses(0) {}
+    : CacheSystem(two_level_config(l1_size, l1_block, l1_assoc,
+                                   l2_size, l2_block, l2_assoc)) {}
 
-void CacheSystem::access(size_t address) {
-    if (l1.access(address))
-        return;
+CacheSystem::CacheSystem(const CacheConfig& cfg)
+    : config(cfg),
+      first_shared(first_shared_level(cfg)),
+      memory_accesses(0),
+      prefetch_memory_accesses(0)
+{
+    levels.reserve(config.levels.size());
+    for (const auto& level : config.levels) {
+        levels.emplace_back(level.size, level.block_size, level.associativity);
+        levels.back().set_eviction_tracking(config.policy != InclusionPolicy::NINE);
+    }
 
-    if (l2.access(address))
-        return;
+    for (size_t i = 0; i < levels.size(); ++i)
+        set_prefetcher(i, config.levels[i].prefetch);
+}
+
+int CacheSystem::access(size_t address, AccessKind kind) {
+    size_t first = (kind == AccessKind::INSTRUCTION && first_shared == 2) ? 1 : 0;
+
+    switch (config.policy) {
+        case InclusionPolicy::INCLUSIVE: return access_inclusive(first, address);
+        case InclusionPolicy::EXCLUSIVE: return access_exclusive(first, address);
+        case InclusionPolicy::NINE:      break;
+    }
+    return access_nine(first, address);
+}
+
+// the path of an access is its L1 followed by every shared level
+int CacheSystem::access_nine(size_t first, size_t address) {
+    bool hit = levels[first].access(address);
+    forward_prefetches(first);
+    if (hit)
+        return first + 1;
+
+    for (size_t i = first_shared; i < levels.size(); ++i) {
+        hit = levels[i].access(address);
+        forward_prefetches(i);
+        if (hit)
+            return i + 1;
+    }
 
-    // miss in both → memory access
+    // miss everywhere → memory access
     memory_accesses++;
+    return 0;
+}
+
+int CacheSystem::access_inclusive(size_t first, size_t address) {
+    bool hit = levels[first].access(address);
+    forward_prefetches(first);
+    if (hit)
+        return first + 1;
+
+    for (size_t i = first_shared; i < levels.size(); ++i) {
+        hit = levels[i].access(address);
+        back_invalidate(i, levels[i].get_evictions());
+        forward_prefetches(i);
+        if (hit)
+            return i + 1;
+    }
+
+    memory_accesses++;
+    return 0;
+}
+
+// a block leaving a shared level may not stay in any level above it
+void CacheSystem::back_invalidate(size_t level, const std::vector<size_t>& evicted) {
+    for (size_t block : evicted)
+        for (size_t i = 0; i < level; ++i)
+            levels[i].invalidate(block);
+}
+
+void CacheSystem::forward_prefetches(size_t level) {
+    const std::vector<size_t>& requests = levels[level].get_prefetch_requests();
+    if (requests.empty())
+        return;
+
+    // exclusive levels hand the block up; the others keep a copy
+    bool take = config.policy == InclusionPolicy::EXCLUSIVE;
+    size_t next = level < first_shared ? first_shared : level + 1;
+
+    for (size_t address : requests) {
+        size_t i = next;
+        for (; i < levels.size(); ++i) {
+            bool hit = levels[i].prefetch_lookup(address, take);
+            if (config.policy == InclusionPolicy::INCLUSIVE)
+                back_invalidate(i, levels[i].get_evictions());
+            if (hit)
+                break;
+        }
+        if (i == levels.size())
+            prefetch_memory_accesses++;
+    }
+}
+
+int CacheSystem::access_exclusive(size_t first, size_t address) {
+    int hit_level = 0;
+
+    if (levels[first].access(address)) {
+        hit_level = first + 1;
+    } else if (first_shared == 2 && levels[1 - first].contains(address)) {
+        // the other half of a split L1 hands the block over
+        levels[1 - first].take(address);
+        hit_level = 2 - first;
+    } else {
+        // the block moves up into L1 from wherever it was found
+        for (size_t i = first_shared; i < levels.size(); ++i) {
+            if (levels[i].take(address)) {
+                hit_level = i + 1;
+                break;
+            }
+        }
+        if (hit_level == 0)
+            memory_accesses++;
+    }
+
+    forward_prefetches(first);
+
+    // L1 victims fill the next level, whose victims fill the one below,
+    // and the last level's victims are dropped
+    victims.clear();
+    for (size_t block : levels[first].get_evictions()) {
+        // a block the other half of a split L1 still holds stays on chip
+        if (first_shared == 2 && levels[1 - first].contains(block))
+            continue;
+        victims.push_back(block);
+    }
+    for (size_t i = first_shared; i < levels.size() && !victims.empty(); ++i) {
+        next_victims.clear();
+        for (size_t block : victims) {
+            levels[i].fill(block);
+            const auto& evicted = levels[i].get_evictions();
+            next_victims.insert(next_victims.end(), evicted.begin(), evicted.end());
+        }
+        victims.swap(next_victims);
+    }
+
+    return hit_level;
+}
+
+int CacheSystem::find_level(const std::string& name) const {
+    for (size_t i = 0; i < config.levels.size(); ++i) {
+        if (same_level_name(config.levels[i].name, name))
+            return static_cast<int>(i);
+    }
+    return -1;
 }
 
+bool CacheSystem::set_prefetcher(size_t level, const PrefetchConfig& prefetch) {
+    if (level >= levels.size())
+        return false;
+
+    levels[level].set_prefetcher(make_prefetcher(prefetch), prefetch.latency);
+    config.levels[level].prefetch = prefetch;
+    return true;
+}
+
+size_t CacheSystem::num_levels() const { return levels.size(); }
+const Cache& CacheSystem::get_level(size_t level) const { return levels[level]; }
+const std::string& CacheSystem::level_name(size_t level) const { return config.levels[level].name; }
+const CacheConfig& CacheSystem::get_config() const { return config; }
+size_t CacheSystem::get_memory_accesses() const { return memory_accesses; }
+size_t CacheSystem::get_prefetch_memory_accesses() const { return prefetch_memory_accesses; }
+
 void CacheSystem::dump_stats() const {
-    l1.dump("L1");
-    l2.dump("L2");
+    if (config.policy != InclusionPolicy::NINE)
+        std::cout << "Inclusion policy: " << inclusion_name(config.policy) << "\n";
+    for (size_t i = 0; i < levels.size(); ++i)
+        levels[i].dump(config.levels[i].name);
     std::cout << "Memory accesses: " << memory_accesses << "\n";
+    if (prefetch_memory_accesses > 0)
+        std::cout << "Prefetch memory accesses: " << prefetch_memory_accesses << "\n";
 }
 
 void CacheSystem::reset() {
-    l1.reset_stats();
-    l2.reset_stats();
+    for (auto& level : levels)
+        level.reset_stats();
     memory_accesses = 0;
+    prefetch_memory_accesses = 0;
 }
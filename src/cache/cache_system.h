@@ -1,20 +1,61 @@
 #ifndef CACHE_SYSTEM_H
 #define CACHE_SYSTEM_H
 
+#include <vector>
+#include <string>
 #include "cache.h"
+#include "cache_config.h"
+
+enum class AccessKind {
+    DATA,
+    INSTRUCTION   // probes L1I instead of L1D when L1 is split
+};
 
 class CacheSystem {
 private:
-    Cache l1;
-    Cache l2;
+    // stored by value, closest to the core first: [L1D, L1I, L2, ...] with
+    // a split L1, [L1, L2, ...] otherwise
+    std::vector<Cache> levels;
+    CacheConfig config;
+    size_t first_shared;
 
     size_t memory_accesses;
+    size_t prefetch_memory_accesses;   // prefetch requests no level held
+
+    // scratch for the exclusive victim cascade
+    std::vector<size_t> victims;
+    std::vector<size_t> next_victims;
+
+    int access_nine(size_t first, size_t address);
+    int access_inclusive(size_t first, size_t address);
+    int access_exclusive(size_t first, size_t address);
+
+    void back_invalidate(size_t level, const std::vector<size_t>& evicted);
+
+    // send the prefetch requests of `level`'s last access down the
+    // hierarchy, as a miss there would go
+    void forward_prefetches(size_t level);
 
 public:
     CacheSystem(size_t l1_size, size_t l1_block, int l1_assoc,
                 size_t l2_size, size_t l2_block, int l2_assoc);
+    explicit CacheSystem(const CacheConfig& config);
+
+    // returns 1 + the index of the level that hit, or 0 for memory
+    int access(size_t address, AccessKind kind = AccessKind::DATA);
+
+    // index of the level with this name (case-insensitive), or -1
+    int find_level(const std::string& name) const;
+
+    // prefetch kind NONE detaches the prefetcher
+    bool set_prefetcher(size_t level, const PrefetchConfig& config);
 
-    void access(size_t address);
+    size_t num_levels() const;
+    const Cache& get_level(size_t level) const;
+    const std::string& level_name(size_t level) const;
+    const CacheConfig& get_config() const;
+    size_t get_memory_accesses() const;
+    size_t get_prefetch_memory_accesses() const;
 
     void dump_stats() const;
     void reset();
@@ -0,0 +1,195 @@
+#include "prefetcher.h"
+#include <sstream>
+
+PrefetchConfig default_prefetch_config() {
+    return PrefetchConfig{PrefetchKind::NONE, 1, 4, 0};
+}
+
+bool parse_prefetch_config(const std::string& spec, PrefetchConfig& config) {
+    PrefetchConfig parsed = default_prefetch_config();
+
+    std::stringstream ss(spec);
+    std::string item;
+    bool first = true;
+
+    while (std::getline(ss, item, ':')) {
+        if (first) {
+            if (item == "none") parsed.kind = PrefetchKind::NONE;
+            else if (item == "nextline") parsed.kind = PrefetchKind::NEXT_LINE;
+            else if (item == "stride") parsed.kind = PrefetchKind::STRIDE;
+            else if (item == "stream") parsed.kind = PrefetchKind::STREAM;
+            else return false;
+            first = false;
+            continue;
+        }
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            return false;
+
+        std::string key = item.substr(0, eq);
+        int value;
+        try {
+            value = std::stoi(item.substr(eq + 1));
+        } catch (...) {
+            return false;
+        }
+        if (value < 0 || (value == 0 && key != "latency"))
+            return false;
+
+        if (key == "degree") parsed.degree = value;
+        else if (key == "streams") parsed.streams = value;
+        else if (key == "latency") parsed.latency = value;
+        else return false;
+    }
+
+    if (first)
+        return false;
+
+    config = parsed;
+    return true;
+}
+
+std::string format_prefetch_config(const PrefetchConfig& config) {
+    std::stringstream ss;
+    switch (config.kind) {
+        case PrefetchKind::NONE:      return "none";
+        case PrefetchKind::NEXT_LINE: ss << "nextline"; break;
+        case PrefetchKind::STRIDE:    ss << "stride"; break;
+        case PrefetchKind::STREAM:    ss << "stream:streams=" << config.streams; break;
+    }
+    ss << ":degree=" << config.degree << ":latency=" << config.latency;
+    return ss.str();
+}
+
+bool Prefetcher::claim(size_t, uint64_t) {
+    return false;
+}
+
+// ------------------ next line ------------------
+
+NextLinePrefetcher::NextLinePrefetcher(int d) : degree(d) {}
+
+void NextLinePrefetcher::on_access(size_t block, bool hit, bool prefetch_hit,
+                                   uint64_t, std::vector<size_t>& fills) {
+    // tagged prefetch: keep running ahead while prefetches are being used
+    if (hit && !prefetch_hit)
+        return;
+
+    for (int k = 1; k <= degree; ++k)
+        fills.push_back(block + k);
+}
+
+// ------------------ stride ------------------
+
+StridePrefetcher::StridePrefetcher(int d)
+    : degree(d), table(TABLE_SIZE, RegionEntry{0, 0, 0, 0, false}) {}
+
+void StridePrefetcher::on_access(size_t block, bool, bool,
+                                 uint64_t, std::vector<size_t>& fills) {
+    size_t region = block >> REGION_SHIFT;
+    RegionEntry& e = table[region % TABLE_SIZE];
+
+    if (!e.valid || e.region != region) {
+        e = RegionEntry{region, block, 0, 0, true};
+        return;
+    }
+
+    long long delta = static_cast<long long>(block) - static_cast<long long>(e.last_block);
+    if (delta == 0)
+        return;
+
+    if (delta == e.stride) {
+        if (e.confidence < 3)
+            e.confidence++;
+    } else {
+        e.stride = delta;
+        e.confidence = 0;
+    }
+    e.last_block = block;
+
+    // two confirmations of the same stride before prefetching
+    if (e.confidence < 2)
+        return;
+
+    for (int k = 1; k <= degree; ++k) {
+        long long target = static_cast<long long>(block) + e.stride * k;
+        if (target < 0)
+            break;
+        fills.push_back(static_cast<size_t>(target));
+    }
+}
+
+// ------------------ stream buffers ------------------
+
+StreamBufferPrefetcher::StreamBufferPrefetcher(int count, int d, int lat)
+    : depth(d), latency(lat), streams(count) {
+    for (auto& s : streams) {
+        s.next = 0;
+        s.last_use = 0;
+        s.valid = false;
+    }
+}
+
+bool StreamBufferPrefetcher::claim(size_t block, uint64_t now) {
+    // only stream heads are compared, as in Jouppi's design
+    for (auto& s : streams) {
+        if (!s.valid || s.lines.empty() || s.lines.front().first != block)
+            continue;
+
+        if (now < s.lines.front().second)
+            stats.late++;
+        else
+            stats.useful++;
+        s.lines.pop_front();
+
+        issue(s.next);
+        s.lines.push_back({s.next++, now + latency});
+        s.last_use = now;
+        return true;
+    }
+    return false;
+}
+
+void StreamBufferPrefetcher::on_access(size_t block, bool hit, bool,
+                                       uint64_t now, std::vector<size_t>&) {
+    if (hit)
+        return;
+
+    // a miss no stream could supply starts a new stream in the LRU buffer
+    Stream* victim = &streams[0];
+    for (auto& s : streams) {
+        if (!s.valid) {
+            victim = &s;
+            break;
+        }
+        if (s.last_use < victim->last_use)
+            victim = &s;
+    }
+
+    stats.polluting += victim->lines.size();
+    victim->lines.clear();
+    victim->valid = true;
+    victim->last_use = now;
+    victim->next = block + 1;
+
+    for (int k = 0; k < depth; ++k) {
+        issue(victim->next);
+        victim->lines.push_back({victim->next++, now + latency});
+    }
+}
+
+std::unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config) {
+    switch (config.kind) {
+        case PrefetchKind::NEXT_LINE:
+            return std::unique_ptr<Prefetcher>(new NextLinePrefetcher(config.degree));
+        case PrefetchKind::STRIDE:
+            return std::unique_ptr<Prefetcher>(new StridePrefetcher(config.degree));
+        case PrefetchKind::STREAM:
+            return std::unique_ptr<Prefetcher>(
+                new StreamBufferPrefetcher(config.streams, config.degree, config.latency));
+        case PrefetchKind::NONE:
+            break;
+    }
+    return nullptr;
+}
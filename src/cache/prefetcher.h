@@ -0,0 +1,135 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+enum class PrefetchKind {
+    NONE,
+    NEXT_LINE,   // next `degree` lines on a miss or first use of a prefetch
+    STRIDE,      // PC-less stride detection per memory region
+    STREAM       // Jouppi-style stream buffers beside the cache
+};
+
+struct PrefetchConfig {
+    PrefetchKind kind;
+    int degree;      // lines per trigger (NEXT_LINE, STRIDE) or depth (STREAM)
+    int streams;     // STREAM: number of stream buffers
+    int latency;     // accesses before a prefetched line is usable
+};
+
+PrefetchConfig default_prefetch_config();
+
+// "none" | "nextline" | "stride" | "stream", optionally followed by
+// ":degree=N", ":streams=N", ":latency=N"
+bool parse_prefetch_config(const std::string& spec, PrefetchConfig& config);
+std::string format_prefetch_config(const PrefetchConfig& config);
+
+// useful: prefetched line demanded after it was ready
+// late: prefetched line demanded before it was ready
+// polluting: prefetched line discarded without ever being demanded
+struct PrefetchStats {
+    size_t issued;
+    size_t useful;
+    size_t late;
+    size_t polluting;
+};
+
+class Prefetcher {
+protected:
+    PrefetchStats stats;
+    std::vector<size_t> requests;
+
+public:
+    Prefetcher() : stats{0, 0, 0, 0} {}
+    virtual ~Prefetcher() = default;
+
+    // observe a demand access to block (address / block size); `hit` is
+    // true if the cache (or claim) supplied it, `prefetch_hit` if it was
+    // the first use of a prefetched line. blocks to fill into the cache
+    // are appended to `fills`
+    virtual void on_access(size_t block, bool hit, bool prefetch_hit,
+                           uint64_t now, std::vector<size_t>& fills) = 0;
+
+    // miss path: true if the prefetcher holds the block itself and hands
+    // it to the cache (stream buffers)
+    virtual bool claim(size_t block, uint64_t now);
+
+    virtual const char* name() const = 0;
+
+    // every prefetched block is fetched from the next level; the cache
+    // drains these after each access and the hierarchy forwards them
+    void issue(size_t block) { stats.issued++; requests.push_back(block); }
+    std::vector<size_t>& get_requests() { return requests; }
+
+    PrefetchStats& get_stats() { return stats; }
+    const PrefetchStats& get_stats() const { return stats; }
+    void reset_stats() { stats = PrefetchStats{0, 0, 0, 0}; }
+};
+
+class NextLinePrefetcher : public Prefetcher {
+private:
+    int degree;
+
+public:
+    explicit NextLinePrefetcher(int degree);
+
+    void on_access(size_t block, bool hit, bool prefetch_hit,
+                   uint64_t now, std::vector<size_t>& fills) override;
+    const char* name() const override { return "nextline"; }
+};
+
+class StridePrefetcher : public Prefetcher {
+private:
+    struct RegionEntry {
+        size_t region;
+        size_t last_block;
+        long long stride;
+        int confidence;
+        bool valid;
+    };
+
+    static const int REGION_SHIFT = 6;     // 64 blocks per region
+    static const size_t TABLE_SIZE = 64;
+
+    int degree;
+    std::vector<RegionEntry> table;
+
+public:
+    explicit StridePrefetcher(int degree);
+
+    void on_access(size_t block, bool hit, bool prefetch_hit,
+                   uint64_t now, std::vector<size_t>& fills) override;
+    const char* name() const override { return "stride"; }
+};
+
+class StreamBufferPrefetcher : public Prefetcher {
+private:
+    struct Stream {
+        std::deque<std::pair<size_t, uint64_t>> lines;  // (block, ready time)
+        size_t next;
+        uint64_t last_use;
+        bool valid;
+    };
+
+    int depth;
+    int latency;
+    std::vector<Stream> streams;
+
+public:
+    StreamBufferPrefetcher(int streams, int depth, int latency);
+
+    void on_access(size_t block, bool hit, bool prefetch_hit,
+                   uint64_t now, std::vector<size_t>& fills) override;
+    bool claim(size_t block, uint64_t now) override;
+    const char* name() const override { return "stream"; }
+};
+
+// nullptr for PrefetchKind::NONE
+std::unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config);
+
+#endif
@@ -1,15 +1,59 @@
 #include "repl.h"
 
 #include "../core/memory.h"
+#include "../core/memory_bench.h"
 #include "../allocator/first_fit.h"
 #include "../allocator/best_fit.h"
 #include "../allocator/worst_fit.h"
 #include "../buddy/buddy_allocator.h"
+#include "../buddy/buddy_bench.h"
+#include "../cache/cache_system.h"
+#include "../trace/trace.h"
+#include "../analysis/locality.h"
+#include "../workload/workload_generator.h"
+#include "../trace/mapped_trace.h"
+#include "../sweep/sweep.h"
+#include "../perf/perf_counters.h"
 
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <fstream>
+
+namespace {
+
+void print_locality(const std::vector<LocalityResult>& results) {
+    std::cout << std::dec << std::setfill(' ') << std::left
+              << std::setw(6) << "Rank" << std::setw(11) << "Policy"
+              << std::right << std::setw(10) << "Accesses";
+    if (!results.empty())
+        for (const auto& level : results[0].levels)
+            std::cout << std::setw(10) << level.name + " miss%";
+    std::cout << std::setw(10) << "Mem%" << std::setw(8) << "Failed"
+              << "\n";
+
+    std::streamsize precision = std::cout.precision();
+    int rank = 1;
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(6) << rank++
+                  << std::setw(11) << policy_name(r.policy)
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << r.accesses;
+        for (const auto& level : r.levels)
+            std::cout << std::setw(10) << level.miss_rate * 100;
+        std::cout << std::setw(10) << r.memory_rate * 100
+                  << std::setw(8) << r.failed_allocs
+                  << std::defaultfloat << "\n";
+    }
+    std::cout.precision(precision);
+}
+
+} // anonymous namespace
 
 void REPL::run() {
 
@@ -34,9 +78,12 @@ void REPL::run() {
     BuddyAllocator buddy;
     bool buddy_initialized = false;
 
-    // buddy: id -> (addr, size)
-    std::unordered_map<int, std::pair<size_t, size_t>> buddy_allocs;
-    int buddy_next_id = 1;
+    // buddy: handle -> (addr, size)
+    HandleTable<std::pair<size_t, size_t>> buddy_allocs;
+
+    // ------------------ cache hierarchy ------------------
+    CacheConfig cache_config = default_cache_config();
+    std::unique_ptr<CacheSystem> cache(new CacheSystem(cache_config));
 
     // ------------------ REPL ------------------
     std::string line;
@@ -62,18 +109,80 @@ void REPL::run() {
         else if (cmd == "init") {
             std::string what;
             size_t size;
-            ss >> what >> size;
+            ss >> what;
+
+            if (what == "cache") {
+                std::vector<std::string> args;
+                std::string arg;
+                while (ss >> arg)
+                    args.push_back(arg);
+
+                bool numeric = args.size() == 6;
+                for (const auto& a : args)
+                    numeric = numeric && a.find_first_not_of("0123456789") == std::string::npos;
+
+                const char* usage =
+                    "Usage: init cache <l1_size> <l1_block> <l1_assoc> "
+                    "<l2_size> <l2_block> <l2_assoc>\n"
+                    "       init cache [name:]size:block:assoc[:prefetch] ..."
+                    " [policy=nine|inclusive|exclusive]\n";
+
+                CacheConfig config;
+                if (numeric) {
+                    // two-level shorthand; keeps L1/L2 prefetcher settings
+                    std::istringstream nums(args[0] + " " + args[1] + " " + args[2] + " " +
+                                            args[3] + " " + args[4] + " " + args[5]);
+                    CacheLevelConfig l1{"L1", 0, 0, 0};
+                    CacheLevelConfig l2{"L2", 0, 0, 0};
+                    if (!(nums >> l1.size >> l1.block_size >> l1.associativity
+                               >> l2.size >> l2.block_size >> l2.associativity)) {
+                        std::cout << usage;
+                        continue;
+                    }
+                    config.levels.push_back(l1);
+                    config.levels.push_back(l2);
+
+                    if (!is_valid_level(config.levels[0]) || !is_valid_level(config.levels[1])) {
+                        std::cout << "Cache size must hold at least one set of "
+                                     "<associativity> blocks\n";
+                        continue;
+                    }
+
+                    for (auto& level : config.levels)
+                        for (const auto& old : cache_config.levels)
+                            if (same_level_name(old.name, level.name))
+                                level.prefetch = old.prefetch;
+                } else {
+                    std::string spec;
+                    for (const auto& a : args)
+                        spec += (spec.empty() ? "" : "/") + a;
+
+                    if (args.empty() || !parse_cache_config(spec, config)) {
+                        std::cout << usage;
+                        continue;
+                    }
+                }
+
+                cache_config = config;
+                cache.reset(new CacheSystem(cache_config));
+                std::cout << "Cache initialized\n";
+                continue;
+            }
+
+            ss >> size;
 
             if (what != "memory") {
                 std::cout << "Usage: init memory <size>\n";
                 continue;
             }
 
-            mem.init(size);
+            if (!mem.init(size)) {
+                std::cout << "Memory size exceeds " << MAX_MEMORY_SIZE << " bytes\n";
+                continue;
+            }
             buddy_initialized = buddy.init(size);
 
             buddy_allocs.clear();
-            buddy_next_id = 1;
             mode = AllocatorMode::NORMAL;
 
             std::cout << "Memory initialized with size " << size << "\n";
@@ -84,6 +193,33 @@ void REPL::run() {
             std::string what, type;
             ss >> what >> type;
 
+            if (what == "coalesce") {
+                if (type == "eager") {
+                    buddy.set_lazy(false, 0);
+                    std::cout << "Buddy coalescing set to eager\n";
+                }
+                else if (type == "lazy") {
+                    // the threshold is optional, but a token that is not a
+                    // whole non-negative number is an error, not 0
+                    size_t threshold = 8;
+                    std::string token;
+                    if (ss >> token) {
+                        std::istringstream num(token);
+                        if (token[0] == '-' || !(num >> threshold) || !num.eof()) {
+                            std::cout << "Usage: set coalesce <eager|lazy [threshold]>\n";
+                            continue;
+                        }
+                    }
+                    buddy.set_lazy(true, threshold);
+                    std::cout << "Buddy coalescing set to lazy (threshold "
+                              << threshold << ")\n";
+                }
+                else {
+                    std::cout << "Usage: set coalesce <eager|lazy [threshold]>\n";
+                }
+                continue;
+            }
+
             if (what != "allocator") {
                 std::cout << "Usage: set allocator <first_fit|best_fit|worst_fit|buddy>\n";
                 continue;
@@ -123,19 +259,18 @@ void REPL::run() {
             ss >> size;
 
             if (mode == AllocatorMode::NORMAL) {
-                int id = mem.allocate(size);
-                if (id == -1)
+                Handle id = mem.allocate(size);
+                if (id == INVALID_HANDLE)
                     std::cout << "Allocation failed\n";
                 else
                     std::cout << "Allocated block id=" << id << "\n";
             }
             else { // BUDDY
-                long long addr = buddy.allocate(size);
-                if (addr == -1) {
+                size_t addr = buddy.allocate(size);
+                if (addr == BuddyAllocator::INVALID_ADDRESS) {
                     std::cout << "Allocation failed\n";
                 } else {
-                    int id = buddy_next_id++;
-                    buddy_allocs[id] = {static_cast<size_t>(addr), size};
+                    Handle id = buddy_allocs.insert({addr, size});
                     std::cout << "Allocated block id=" << id
                               << " at address " << addr << "\n";
                 }
@@ -144,24 +279,358 @@ void REPL::run() {
 
         // ------------------ free ------------------
         else if (cmd == "free") {
-            int id;
+            Handle id = INVALID_HANDLE;
             ss >> id;
 
             if (mode == AllocatorMode::NORMAL) {
                 if (mem.deallocate(id))
                     std::cout << "Block " << id << " freed\n";
+                else if (mem.handle_status(id) == HandleStatus::STALE)
+                    std::cout << "Block " << id << " already freed\n";
                 else
                     std::cout << "Invalid block id\n";
             }
             else { // BUDDY
-                auto it = buddy_allocs.find(id);
-                if (it == buddy_allocs.end()) {
+                auto* alloc = buddy_allocs.find(id);
+                if (alloc) {
+                    buddy.deallocate(alloc->first, alloc->second);
+                    buddy_allocs.release(id);
+                    std::cout << "Block " << id << " freed\n";
+                } else if (buddy_allocs.status(id) == HandleStatus::STALE) {
+                    std::cout << "Block " << id << " already freed\n";
+                } else {
                     std::cout << "Invalid block id\n";
+                }
+            }
+        }
+
+        // ------------------ realloc ------------------
+        else if (cmd == "realloc") {
+            Handle id;
+            size_t size;
+            if (!(ss >> id >> size)) {
+                std::cout << "Usage: realloc <block_id> <size>\n";
+                continue;
+            }
+
+            if (mode == AllocatorMode::NORMAL) {
+                ReallocResult result = mem.reallocate(id, size);
+                if (result == ReallocResult::FAILED)
+                    std::cout << "Reallocation failed\n";
+                else if (result == ReallocResult::IN_PLACE)
+                    std::cout << "Block " << id << " resized in place\n";
+                else
+                    std::cout << "Block " << id << " moved\n";
+            }
+            else { // BUDDY
+                auto* alloc = buddy_allocs.find(id);
+                if (!alloc) {
+                    std::cout << "Invalid block id\n";
+                    continue;
+                }
+
+                size_t old_addr = alloc->first;
+                size_t addr = buddy.reallocate(old_addr, alloc->second, size);
+                if (addr == BuddyAllocator::INVALID_ADDRESS) {
+                    std::cout << "Reallocation failed\n";
                 } else {
-                    buddy.deallocate(it->second.first, it->second.second);
-                    buddy_allocs.erase(it);
-                    std::cout << "Block " << id << " freed\n";
+                    *alloc = {addr, size};
+                    if (addr == old_addr)
+                        std::cout << "Block " << id << " resized in place\n";
+                    else
+                        std::cout << "Block " << id
+                                  << " moved to address " << addr << "\n";
+                }
+            }
+        }
+
+        // ------------------ compact ------------------
+        else if (cmd == "compact") {
+            size_t budget = 0;
+            ss >> budget;
+
+            if (mode != AllocatorMode::NORMAL) {
+                std::cout << "Compaction not supported for Buddy allocator\n";
+                continue;
+            }
+
+            CompactionResult result = mem.compact(budget);
+            std::cout << std::dec << "Compaction " << (result.complete ? "complete" : "partial")
+                      << ": " << result.relocations.size() << " blocks, "
+                      << result.bytes_moved << " bytes moved\n";
+            for (const auto& r : result.relocations) {
+                std::cout << "  id=" << r.id << " 0x"
+                          << std::hex << std::setw(4) << std::setfill('0') << r.old_start
+                          << " -> 0x" << std::setw(4) << r.new_start
+                          << std::dec << std::setfill(' ') << "\n";
+            }
+        }
+
+        // ------------------ access ------------------
+        else if (cmd == "access" || cmd == "ifetch") {
+            size_t first, offset;
+            if (!(ss >> first)) {
+                std::cout << "Usage: access <address> | access <block_id> <offset>"
+                             " | ifetch <address>\n";
+                continue;
+            }
+
+            size_t address = first;
+
+            // block id + offset: translate through the current placement
+            if (ss >> offset) {
+                Handle id = first;
+                size_t start = 0, size = 0;
+                bool found = false;
+
+                if (mode == AllocatorMode::NORMAL) {
+                    found = mem.get_block(id, start, size);
+                } else {
+                    auto* alloc = buddy_allocs.find(id);
+                    if (alloc) {
+                        start = alloc->first;
+                        size = alloc->second;
+                        found = true;
+                    }
+                }
+
+                if (!found) {
+                    std::cout << "Invalid block id\n";
+                    continue;
                 }
+                if (offset >= size) {
+                    std::cout << "Offset outside block\n";
+                    continue;
+                }
+                address = start + offset;
+            }
+
+            // at most one level's stream buffer can supply an access: the
+            // level that reports it, so a change in the total identifies it
+            size_t buffer_hits = 0;
+            for (size_t i = 0; i < cache->num_levels(); ++i)
+                buffer_hits += cache->get_level(i).get_buffer_hits();
+
+            int level = cache->access(address, cmd == "ifetch" ? AccessKind::INSTRUCTION
+                                                               : AccessKind::DATA);
+
+            for (size_t i = 0; i < cache->num_levels(); ++i)
+                buffer_hits -= cache->get_level(i).get_buffer_hits();
+
+            std::cout << "Address " << address << ": ";
+            if (level == 0)
+                std::cout << "memory access\n";
+            else if (buffer_hits != 0)
+                std::cout << cache->level_name(level - 1) << " stream buffer hit\n";
+            else
+                std::cout << cache->level_name(level - 1) << " hit\n";
+        }
+
+        // ------------------ cache ------------------
+        else if (cmd == "cache") {
+            std::string what;
+            ss >> what;
+
+            if (what == "stats") {
+                cache->dump_stats();
+            } else if (what == "reset") {
+                cache->reset();
+                std::cout << "Cache statistics reset\n";
+            } else {
+                std::cout << "Usage: cache <stats|reset>\n";
+            }
+        }
+
+        // ------------------ prefetch ------------------
+        else if (cmd == "prefetch") {
+            std::string level, spec, option;
+            ss >> level >> spec;
+            while (ss >> option)
+                spec += ":" + option;
+
+            PrefetchConfig config;
+            int index = cache->find_level(level);
+            if (index < 0 || !parse_prefetch_config(spec, config)) {
+                std::cout << "Usage: prefetch <level> <none|nextline|stride|stream>"
+                             " [degree=N] [streams=N] [latency=N]\n";
+                continue;
+            }
+
+            cache->set_prefetcher(index, config);
+            cache_config.levels[index].prefetch = config;
+            std::cout << cache->level_name(index) << " prefetcher: "
+                      << format_prefetch_config(config) << "\n";
+        }
+
+        // ------------------ locality ------------------
+        else if (cmd == "locality") {
+            std::string path;
+            ss >> path;
+
+            TraceReader reader;
+            if (path.empty()) {
+                std::cout << "Usage: locality <trace_file>\n";
+                continue;
+            }
+            if (!reader.open(path)) {
+                std::cout << "Cannot read trace: " << reader.get_error() << "\n";
+                continue;
+            }
+            if (mem.get_total_memory() == 0) {
+                std::cout << "Initialize memory first\n";
+                continue;
+            }
+
+            print_locality(analyze_locality(reader, mem.get_total_memory(), cache_config));
+            if (reader.is_truncated())
+                std::cout << "Warning: trace truncated, replayed " << reader.get_records_read()
+                          << " of " << reader.get_header_count() << " ops\n";
+        }
+
+        // ------------------ generate / workload ------------------
+        else if (cmd == "generate" || cmd == "workload") {
+            std::string path;
+            if (cmd == "generate")
+                ss >> path;
+
+            WorkloadConfig config;
+            std::string option;
+            bool valid = cmd == "workload" || !path.empty();
+            while (valid && ss >> option) {
+                if (!set_workload_option(config, option)) {
+                    std::cout << "Invalid option " << option << "\n";
+                    valid = false;
+                }
+            }
+            if (!valid) {
+                std::cout << "Usage: " << cmd << (cmd == "generate" ? " <file>" : "")
+                          << " [ops=N] [seed=N] [size=uniform|lognormal|powerlaw|classes]"
+                             " [min=N] [max=N] [param=X]"
+                             " [lifetime=lifo|fifo|exp|phase] [mean_life=X]"
+                             " [max_live=N] [phase=N]"
+                             " [access=seq|stride|zipf|chase] [access_ratio=X]"
+                             " [stride=N] [theta=X]\n";
+                continue;
+            }
+
+            WorkloadGenerator generator(config);
+
+            if (cmd == "workload") {
+                // in-process feed, nothing is materialized
+                if (mem.get_total_memory() == 0) {
+                    std::cout << "Initialize memory first\n";
+                    continue;
+                }
+                print_locality(analyze_locality(generator, mem.get_total_memory(), cache_config));
+                continue;
+            }
+
+            TraceWriter writer;
+            if (!writer.open(path)) {
+                std::cout << "Cannot write " << path << "\n";
+                continue;
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            TraceOp op;
+            while (generator.next(op))
+                writer.write(op);
+            bool ok = writer.close();
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+
+            if (!ok)
+                std::cout << "Error writing " << path << "\n";
+            else
+                std::cout << std::dec << "Wrote " << writer.get_count() << " ops to "
+                          << path << " in " << seconds << "s\n";
+        }
+
+        // ------------------ sweep ------------------
+        else if (cmd == "sweep") {
+            std::string out_path;
+            ss >> out_path;
+
+            SweepConfig config;
+            config.policies = {PlacementPolicy::FIRST_FIT, PlacementPolicy::BEST_FIT,
+                               PlacementPolicy::WORST_FIT, PlacementPolicy::BUDDY};
+            config.memory_sizes = {mem.get_total_memory() > 0 ? mem.get_total_memory() : 65536};
+            config.caches = {cache_config};
+            config.threads = 0;
+
+            std::string trace_path;
+            std::string option;
+            bool valid = !out_path.empty();
+            while (valid && ss >> option) {
+                if (option.compare(0, 6, "trace=") == 0) {
+                    trace_path = option.substr(6);
+                } else if (!set_sweep_option(config, option)) {
+                    std::cout << "Invalid option " << option << "\n";
+                    valid = false;
+                }
+            }
+            if (!valid) {
+                std::cout << "Usage: sweep <out.csv> [trace=<file>]"
+                             " [policies=first_fit,best_fit,worst_fit,buddy]"
+                             " [sizes=N,N] [caches=level/level[/policy=P],...]"
+                             " [seeds=N,N] [threads=N] [workload options]\n";
+                continue;
+            }
+
+            MappedTrace trace;
+            if (!trace_path.empty() && !trace.open(trace_path)) {
+                std::cout << "Cannot read trace: " << trace.get_error() << "\n";
+                continue;
+            }
+            if (trace.is_truncated())
+                std::cout << "Warning: trace truncated, replaying " << trace.size()
+                          << " of " << trace.expected_size() << " ops\n";
+
+            auto begin = std::chrono::steady_clock::now();
+            std::vector<SweepResult> results =
+                run_sweep(config, trace_path.empty() ? nullptr : &trace);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+
+            if (!write_sweep_csv(out_path, results, !trace_path.empty()))
+                std::cout << "Cannot write " << out_path << "\n";
+            else
+                std::cout << std::dec << "Ran " << results.size() << " simulations in "
+                          << seconds << "s, results written to " << out_path << "\n";
+        }
+
+        // ------------------ perf ------------------
+        else if (cmd == "perf") {
+            std::string what, path;
+            ss >> what >> path;
+
+            if (!PERF_ENABLED) {
+                std::cout << "Instrumentation disabled; rebuild with make INSTRUMENT=1\n";
+                continue;
+            }
+
+            std::vector<size_t> lengths;
+            if (buddy_initialized) {
+                for (int k = 0; k <= buddy.get_max_order(); ++k)
+                    lengths.push_back(buddy.get_free_list_length(k));
+            }
+
+            if (what.empty()) {
+                std::cout << std::dec;
+                perf_dump(std::cout, lengths);
+            } else if (what == "reset") {
+                perf_reset();
+                std::cout << "Performance counters reset\n";
+            } else if (what == "json" && !path.empty()) {
+                std::ofstream out(path);
+                if (!out) {
+                    std::cout << "Cannot write " << path << "\n";
+                    continue;
+                }
+                perf_dump_json(out, lengths);
+                std::cout << "Performance counters written to " << path << "\n";
+            } else {
+                std::cout << "Usage: perf [reset | json <file>]\n";
             }
         }
 
@@ -183,8 +652,101 @@ void REPL::run() {
                           << mem.get_utilization() << "%\n";
                 std::cout << "External fragmentation: "
                           << mem.get_external_fragmentation() << "%\n";
+                std::cout << "Reallocs in place: " << mem.get_realloc_in_place() << "\n";
+                std::cout << "Reallocs moved: " << mem.get_realloc_moved() << "\n";
+                std::cout << "Bytes moved: " << mem.get_bytes_moved() << "\n";
+                std::cout << "Stale handle rejections: "
+                          << mem.get_stale_rejections() << "\n";
+                std::cout << "Compactions: " << mem.get_compaction_runs() << "\n";
+                std::cout << "Compaction bytes moved: "
+                          << mem.get_compaction_bytes() << "\n";
             } else {
-                std::cout << "Stats not implemented for Buddy allocator\n";
+                std::cout << "Total memory: " << buddy.get_total_memory() << "\n";
+                std::cout << "Free memory: " << buddy.get_free_memory() << "\n";
+                std::cout << "Largest free block: "
+                          << buddy.get_largest_free_block() << "\n";
+                std::cout << "Free blocks: " << buddy.get_free_block_count() << "\n";
+                std::cout << "Deferred blocks: " << buddy.get_deferred_count() << "\n";
+                std::cout << "External fragmentation: "
+                          << buddy.get_external_fragmentation() << "%\n";
+                std::cout << "Reallocs in place: " << buddy.get_realloc_in_place() << "\n";
+                std::cout << "Reallocs moved: " << buddy.get_realloc_moved() << "\n";
+                std::cout << "Bytes moved: " << buddy.get_bytes_moved() << "\n";
+            }
+        }
+
+        // ------------------ bench ------------------
+        else if (cmd == "bench") {
+            std::string what;
+            ss >> what;
+
+            if (what == "memory") {
+                size_t blocks = 1000000;
+                ss >> blocks;
+                size_t churn = blocks;
+                ss >> churn;
+
+                const struct {
+                    const char* name;
+                    Allocator* policy;
+                } policies[] = {
+                    {"first_fit", &firstFit},
+                    {"best_fit", &bestFit},
+                    {"worst_fit", &worstFit}
+                };
+
+                for (const auto& p : policies) {
+                    MemoryBenchResult r = run_memory_soak(p.policy, blocks, churn, 1);
+
+                    std::cout << "Soak " << p.name << " (" << blocks << " blocks, "
+                              << churn << " churn ops)\n";
+                    std::cout << "  fill: " << r.fill_ops_per_sec << " mallocs/sec, "
+                              << "churn: " << r.churn_ops_per_sec << " ops/sec, "
+                              << "failures " << r.failures << "\n";
+                    std::cout << "  blocks " << r.total_blocks << ", "
+                              << "metadata " << r.metadata_bytes << " bytes, "
+                              << r.bytes_per_block << " bytes/block\n";
+                }
+                continue;
+            }
+
+            size_t ops = 1000000;
+            size_t threshold = 8;
+            ss >> ops >> threshold;
+
+            if (what != "buddy") {
+                std::cout << "Usage: bench buddy [ops] [threshold] | bench memory [blocks] [churn]\n";
+                continue;
+            }
+            if (!buddy_initialized) {
+                std::cout << "Buddy allocator requires memory size to be a power of two\n";
+                continue;
+            }
+
+            const struct {
+                const char* name;
+                ChurnTrace trace;
+            } traces[] = {
+                {"same-size", ChurnTrace::SAME_SIZE},
+                {"mixed", ChurnTrace::MIXED}
+            };
+
+            for (const auto& t : traces) {
+                BuddyBenchResult eager = run_buddy_churn(
+                    t.trace, buddy.get_total_memory(), ops, 0, 1);
+                BuddyBenchResult lazy = run_buddy_churn(
+                    t.trace, buddy.get_total_memory(), ops, threshold, 1);
+
+                std::cout << "Trace " << t.name << " (" << ops << " ops)\n";
+                std::cout << "  eager: " << eager.ops_per_sec << " ops/sec, "
+                          << "fragmentation " << eager.fragmentation << "%, "
+                          << "free blocks " << eager.free_blocks << ", "
+                          << "failures " << eager.failures << "\n";
+                std::cout << "  lazy:  " << lazy.ops_per_sec << " ops/sec, "
+                          << "fragmentation " << lazy.fragmentation << "%, "
+                          << "free blocks " << lazy.free_blocks << ", "
+                          << "failures " << lazy.failures << ", "
+                          << "coalesce runs " << lazy.coalesce_runs << "\n";
             }
         }
 
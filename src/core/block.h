@@ -2,12 +2,27 @@
 #define BLOCK_H
 
 #include <cstddef>
+#include <cstdint>
 
+// index of "no block" in Memory's block records
+const uint32_t NO_BLOCK = UINT32_MAX;
+
+// One 16-byte record per block. Blocks tile memory in address order,
+// linked through `next`, so a block's size is the next block's start (or
+// the end of memory) minus its own start and is not stored.
 struct Block {
-    size_t start;
-    size_t size;
-    bool free;
-    int id;
+    uint64_t start : 47;
+    uint64_t free : 1;
+    uint32_t slot;      // handle-table slot of a used block
+    uint32_t next;      // next block by address, or NO_BLOCK
+
+    Block(size_t start_, bool free_, uint32_t next_)
+        : start(start_), free(free_), slot(0), next(next_) {}
 };
 
+static_assert(sizeof(Block) == 16, "Block fields must stay 16 bytes");
+
+// largest value a 47-bit start field can hold
+const size_t MAX_MEMORY_SIZE = (1ULL << 47) - 1;
+
 #endif
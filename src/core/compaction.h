@@ -0,0 +1,21 @@
+#ifndef COMPACTION_H
+#define COMPACTION_H
+
+#include <vector>
+#include <cstddef>
+#include "handle_table.h"
+
+// one used block slid to a lower address
+struct Relocation {
+    Handle id;
+    size_t old_start;
+    size_t new_start;
+};
+
+struct CompactionResult {
+    std::vector<Relocation> relocations;
+    size_t bytes_moved;
+    bool complete;      // false if the byte budget stopped the pass early
+};
+
+#endif
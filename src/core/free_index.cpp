@@ -0,0 +1,280 @@
+#include "free_index.h"
+#include "../perf/perf_counters.h"
+#include <algorithm>
+
+FreeIndex::FreeIndex()
+    : spare(NO_BLOCK), addr_root(NO_BLOCK), size_root(NO_BLOCK),
+      seed(2463534242u), count(0) {}
+
+void FreeIndex::clear() {
+    nodes.clear();
+    spare = NO_BLOCK;
+    addr_root = NO_BLOCK;
+    size_root = NO_BLOCK;
+    count = 0;
+}
+
+uint32_t FreeIndex::new_node(uint32_t block, size_t start, size_t size) {
+    // xorshift32: deterministic priorities keep runs reproducible
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    Node node = {start, size, size, block, seed,
+                 {NO_BLOCK, NO_BLOCK}, {NO_BLOCK, NO_BLOCK}};
+
+    if (spare != NO_BLOCK) {
+        uint32_t n = spare;
+        spare = nodes[n].by_addr[0];
+        nodes[n] = node;
+        return n;
+    }
+
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void FreeIndex::update(uint32_t n) {
+    size_t max_size = nodes[n].size;
+    for (uint32_t child : nodes[n].by_addr) {
+        if (child != NO_BLOCK)
+            max_size = std::max(max_size, nodes[child].max_size);
+    }
+    nodes[n].max_size = max_size;
+}
+
+// ------------------ address treap ------------------
+
+// l gets the starts below `start`, r the rest
+void FreeIndex::split_addr(uint32_t t, size_t start, uint32_t& l, uint32_t& r) {
+    if (t == NO_BLOCK) {
+        l = r = NO_BLOCK;
+        return;
+    }
+
+    if (nodes[t].start < start) {
+        split_addr(nodes[t].by_addr[1], start, nodes[t].by_addr[1], r);
+        l = t;
+    } else {
+        split_addr(nodes[t].by_addr[0], start, l, nodes[t].by_addr[0]);
+        r = t;
+    }
+    update(t);
+}
+
+uint32_t FreeIndex::insert_addr(uint32_t t, uint32_t n) {
+    if (t == NO_BLOCK)
+        return n;
+
+    if (nodes[n].priority > nodes[t].priority) {
+        split_addr(t, nodes[n].start, nodes[n].by_addr[0], nodes[n].by_addr[1]);
+        update(n);
+        return n;
+    }
+
+    int side = nodes[n].start > nodes[t].start;
+    uint32_t child = insert_addr(nodes[t].by_addr[side], n);
+    nodes[t].by_addr[side] = child;
+    update(t);
+    return t;
+}
+
+uint32_t FreeIndex::erase_addr(uint32_t t, size_t start) {
+    if (t == NO_BLOCK)
+        return NO_BLOCK;
+
+    if (nodes[t].start == start)
+        return merge_addr(nodes[t].by_addr[0], nodes[t].by_addr[1]);
+
+    int side = start > nodes[t].start;
+    uint32_t child = erase_addr(nodes[t].by_addr[side], start);
+    nodes[t].by_addr[side] = child;
+    update(t);
+    return t;
+}
+
+uint32_t FreeIndex::merge_addr(uint32_t l, uint32_t r) {
+    if (l == NO_BLOCK)
+        return r;
+    if (r == NO_BLOCK)
+        return l;
+
+    if (nodes[l].priority > nodes[r].priority) {
+        uint32_t child = merge_addr(nodes[l].by_addr[1], r);
+        nodes[l].by_addr[1] = child;
+        update(l);
+        return l;
+    }
+
+    uint32_t child = merge_addr(l, nodes[r].by_addr[0]);
+    nodes[r].by_addr[0] = child;
+    update(r);
+    return r;
+}
+
+// ------------------ (size, start) treap ------------------
+
+bool FreeIndex::size_before(uint32_t a, uint32_t b) const {
+    if (nodes[a].size != nodes[b].size)
+        return nodes[a].size < nodes[b].size;
+    return nodes[a].start < nodes[b].start;
+}
+
+// l gets the nodes ordered before `key`, r the rest
+void FreeIndex::split_size(uint32_t t, uint32_t key, uint32_t& l, uint32_t& r) {
+    if (t == NO_BLOCK) {
+        l = r = NO_BLOCK;
+        return;
+    }
+
+    if (size_before(t, key)) {
+        split_size(nodes[t].by_size[1], key, nodes[t].by_size[1], r);
+        l = t;
+    } else {
+        split_size(nodes[t].by_size[0], key, l, nodes[t].by_size[0]);
+        r = t;
+    }
+}
+
+uint32_t FreeIndex::insert_size(uint32_t t, uint32_t n) {
+    if (t == NO_BLOCK)
+        return n;
+
+    if (nodes[n].priority > nodes[t].priority) {
+        split_size(t, n, nodes[n].by_size[0], nodes[n].by_size[1]);
+        return n;
+    }
+
+    int side = size_before(t, n);
+    uint32_t child = insert_size(nodes[t].by_size[side], n);
+    nodes[t].by_size[side] = child;
+    return t;
+}
+
+uint32_t FreeIndex::erase_size(uint32_t t, uint32_t n) {
+    if (t == NO_BLOCK)
+        return NO_BLOCK;
+
+    if (t == n)
+        return merge_size(nodes[t].by_size[0], nodes[t].by_size[1]);
+
+    int side = size_before(t, n);
+    uint32_t child = erase_size(nodes[t].by_size[side], n);
+    nodes[t].by_size[side] = child;
+    return t;
+}
+
+uint32_t FreeIndex::merge_size(uint32_t l, uint32_t r) {
+    if (l == NO_BLOCK)
+        return r;
+    if (r == NO_BLOCK)
+        return l;
+
+    if (nodes[l].priority > nodes[r].priority) {
+        uint32_t child = merge_size(nodes[l].by_size[1], r);
+        nodes[l].by_size[1] = child;
+        return l;
+    }
+
+    uint32_t child = merge_size(l, nodes[r].by_size[0]);
+    nodes[r].by_size[0] = child;
+    return r;
+}
+
+// ------------------ public ------------------
+
+void FreeIndex::insert(uint32_t block, size_t start, size_t size) {
+    uint32_t n = new_node(block, start, size);
+    addr_root = insert_addr(addr_root, n);
+    size_root = insert_size(size_root, n);
+    count++;
+}
+
+void FreeIndex::erase(size_t start) {
+    uint32_t n = addr_root;
+    while (n != NO_BLOCK && nodes[n].start != start)
+        n = nodes[n].by_addr[start > nodes[n].start];
+    if (n == NO_BLOCK)
+        return;
+
+    // the size treap is searched with the node's own key, so it must be
+    // unlinked before the node is recycled
+    size_root = erase_size(size_root, n);
+    addr_root = erase_addr(addr_root, start);
+
+    nodes[n].by_addr[0] = spare;
+    spare = n;
+    count--;
+}
+
+uint32_t FreeIndex::first_fit(size_t size) const {
+    uint32_t t = addr_root;
+    if (t == NO_BLOCK || nodes[t].max_size < size)
+        return NO_BLOCK;
+
+    // the leftmost node whose subtree has room; max_size guarantees
+    // one of the three places below does
+    for (;;) {
+        PERF_COUNT(scan_steps, 1);
+        uint32_t left = nodes[t].by_addr[0];
+        if (left != NO_BLOCK && nodes[left].max_size >= size)
+            t = left;
+        else if (nodes[t].size >= size)
+            return nodes[t].block;
+        else
+            t = nodes[t].by_addr[1];
+    }
+}
+
+uint32_t FreeIndex::best_fit(size_t size) const {
+    // lower bound of (size, 0) in the size treap
+    uint32_t best = NO_BLOCK;
+    for (uint32_t t = size_root; t != NO_BLOCK; ) {
+        PERF_COUNT(scan_steps, 1);
+        if (nodes[t].size >= size) {
+            best = t;
+            t = nodes[t].by_size[0];
+        } else {
+            t = nodes[t].by_size[1];
+        }
+    }
+    return best == NO_BLOCK ? NO_BLOCK : nodes[best].block;
+}
+
+uint32_t FreeIndex::worst_fit(size_t size) const {
+    size_t max_size = largest();
+    if (count == 0 || max_size < size)
+        return NO_BLOCK;
+
+    // the lowest address among the largest blocks
+    return first_fit(max_size);
+}
+
+uint32_t FreeIndex::ending_at(size_t addr) const {
+    // predecessor by start address
+    uint32_t prev = NO_BLOCK;
+    for (uint32_t t = addr_root; t != NO_BLOCK; ) {
+        if (nodes[t].start < addr) {
+            prev = t;
+            t = nodes[t].by_addr[1];
+        } else {
+            t = nodes[t].by_addr[0];
+        }
+    }
+
+    if (prev == NO_BLOCK || nodes[prev].start + nodes[prev].size != addr)
+        return NO_BLOCK;
+    return nodes[prev].block;
+}
+
+size_t FreeIndex::largest() const {
+    return addr_root == NO_BLOCK ? 0 : nodes[addr_root].max_size;
+}
+
+size_t FreeIndex::size() const {
+    return count;
+}
+
+size_t FreeIndex::memory_bytes() const {
+    return nodes.size() * sizeof(Node);
+}
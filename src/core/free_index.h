@@ -0,0 +1,73 @@
+#ifndef FREE_INDEX_H
+#define FREE_INDEX_H
+
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include "block.h"
+
+// Free blocks of a Memory, indexed for the placement policies. Each free
+// block is one node in two treaps sharing the same priorities: one
+// ordered by start address and tracking the largest size per subtree
+// (first fit), one ordered by (size, start) (best and worst fit). Every
+// query and update is O(log F) expected in the number of free blocks.
+// Ties go to the lowest address, as a front-to-back list scan would.
+class FreeIndex {
+private:
+    struct Node {
+        size_t start;
+        size_t size;
+        size_t max_size;        // largest size in the address subtree
+        uint32_t block;         // Memory's block record
+        uint32_t priority;
+        uint32_t by_addr[2];
+        uint32_t by_size[2];
+    };
+
+    std::deque<Node> nodes;
+    uint32_t spare;             // recycled nodes, chained through by_addr[0]
+    uint32_t addr_root;
+    uint32_t size_root;
+    uint32_t seed;
+    size_t count;
+
+    uint32_t new_node(uint32_t block, size_t start, size_t size);
+    void update(uint32_t n);
+
+    // address treap
+    void split_addr(uint32_t t, size_t start, uint32_t& l, uint32_t& r);
+    uint32_t insert_addr(uint32_t t, uint32_t n);
+    uint32_t erase_addr(uint32_t t, size_t start);
+    uint32_t merge_addr(uint32_t l, uint32_t r);
+
+    // (size, start) treap
+    bool size_before(uint32_t a, uint32_t b) const;
+    void split_size(uint32_t t, uint32_t key, uint32_t& l, uint32_t& r);
+    uint32_t insert_size(uint32_t t, uint32_t n);
+    uint32_t erase_size(uint32_t t, uint32_t n);
+    uint32_t merge_size(uint32_t l, uint32_t r);
+
+public:
+    FreeIndex();
+
+    void clear();
+
+    // nodes keep their own keys: a free block whose start or size
+    // changes is erased under its old start and inserted again
+    void insert(uint32_t block, size_t start, size_t size);
+    void erase(size_t start);
+
+    // block chosen by each policy for `size` bytes, or NO_BLOCK
+    uint32_t first_fit(size_t size) const;    // lowest address that fits
+    uint32_t best_fit(size_t size) const;     // smallest that fits
+    uint32_t worst_fit(size_t size) const;    // largest, if it fits
+
+    // free block whose range ends exactly at addr, or NO_BLOCK
+    uint32_t ending_at(size_t addr) const;
+
+    size_t largest() const;     // 0 when there is no free block
+    size_t size() const;
+    size_t memory_bytes() const;
+};
+
+#endif
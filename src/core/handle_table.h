@@ -0,0 +1,133 @@
+#ifndef HANDLE_TABLE_H
+#define HANDLE_TABLE_H
+
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit block handle: generation << 32 | (slot + 1). 0 is never issued.
+using Handle = uint64_t;
+const Handle INVALID_HANDLE = 0;
+
+enum class HandleStatus {
+    LIVE,
+    STALE,      // slot was released since: use-after-free or double free
+    UNKNOWN     // never issued
+};
+
+// Slot table behind generation-tagged handles. Releasing a slot bumps
+// its generation so old handles stop matching. Released slots are reused
+// FIFO, and only once QUARANTINE of them are waiting: short sessions keep
+// sequential ids (1, 2, 3, ...) and reuse is delayed as long as possible.
+template <typename T>
+class HandleTable {
+private:
+    // live shares a word with a 31-bit generation, so a uint32_t value
+    // makes an 8-byte slot
+    struct Slot {
+        T value;
+        uint32_t generation : 31;
+        uint32_t live : 1;
+    };
+
+    // chunked, so growing never copies the table or doubles its footprint
+    std::deque<Slot> slots;
+    std::deque<uint32_t> released;
+    size_t live_count;
+    size_t stale_rejections;
+
+public:
+    static const size_t QUARANTINE = 1024;
+    static const uint32_t MAX_SLOTS = 0xfffffffeu;
+
+    HandleTable() : live_count(0), stale_rejections(0) {}
+
+    static uint32_t slot_of(Handle h) {
+        return static_cast<uint32_t>(h & 0xffffffffu) - 1;
+    }
+
+    Handle handle_of(uint32_t slot) const {
+        return (static_cast<Handle>(slots[slot].generation) << 32) | (slot + 1ULL);
+    }
+
+    HandleStatus status(Handle h) const {
+        uint32_t slot = slot_of(h);
+        if ((h & 0xffffffffu) == 0 || slot >= slots.size())
+            return HandleStatus::UNKNOWN;
+        if (slots[slot].live && handle_of(slot) == h)
+            return HandleStatus::LIVE;
+        if (static_cast<uint32_t>(h >> 32) < slots[slot].generation)
+            return HandleStatus::STALE;
+        return HandleStatus::UNKNOWN;
+    }
+
+    // returns INVALID_HANDLE once every slot is live
+    Handle insert(const T& value) {
+        uint32_t slot;
+        if (released.size() > QUARANTINE || (!released.empty() && slots.size() >= MAX_SLOTS)) {
+            slot = released.front();
+            released.pop_front();
+        } else if (slots.size() < MAX_SLOTS) {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back({value, 0, false});
+        } else {
+            return INVALID_HANDLE;
+        }
+
+        slots[slot].value = value;
+        slots[slot].live = true;
+        live_count++;
+        return handle_of(slot);
+    }
+
+    // value behind a live handle, or nullptr
+    T* find(Handle h) {
+        if (status(h) != HandleStatus::LIVE)
+            return nullptr;
+        return &slots[slot_of(h)].value;
+    }
+
+    const T* find(Handle h) const {
+        if (status(h) != HandleStatus::LIVE)
+            return nullptr;
+        return &slots[slot_of(h)].value;
+    }
+
+    // value of a live slot by index, for owners that store slot numbers
+    T& at_slot(uint32_t slot) {
+        return slots[slot].value;
+    }
+
+    bool release(Handle h) {
+        HandleStatus s = status(h);
+        if (s != HandleStatus::LIVE) {
+            if (s == HandleStatus::STALE)
+                stale_rejections++;
+            return false;
+        }
+
+        uint32_t slot = slot_of(h);
+        slots[slot].live = false;
+        slots[slot].generation++;
+        released.push_back(slot);
+        live_count--;
+        return true;
+    }
+
+    void clear() {
+        slots.clear();
+        released.clear();
+        live_count = 0;
+        stale_rejections = 0;
+    }
+
+    size_t size() const { return live_count; }
+
+    // bytes held by the slot table and the release queue
+    size_t memory_bytes() const {
+        return slots.size() * sizeof(Slot) + released.size() * sizeof(uint32_t);
+    }
+    size_t get_stale_rejections() const { return stale_rejections; }
+};
+
+#endif
@@ -1,64 +1,120 @@
 #include "memory.h"
 #include "../allocator/allocator.h"
+#include "../perf/perf_counters.h"
 #include <iostream>
 #include <iomanip>
 
 
 Memory::Memory()
-    : total_size(0), next_id(1), allocator(nullptr),
-      alloc_success(0), alloc_failure(0) {}
+    : total_size(0), used_size(0), head(NO_BLOCK), spare(NO_BLOCK),
+      allocator(nullptr),
+      alloc_success(0), alloc_failure(0),
+      realloc_in_place(0), realloc_moved(0), bytes_moved(0),
+      compaction_runs(0), compaction_bytes(0) {}
+
+bool Memory::init(size_t size) {
+    if (size > MAX_MEMORY_SIZE)
+        return false;
 
-void Memory::init(size_t size) {
     total_size = size;
+    used_size = 0;
     blocks.clear();
-    blocks.push_back({0, size, true, -1});
-    next_id = 1;
+    spare = NO_BLOCK;
+    head = new_block(0, true, NO_BLOCK);
+    free_blocks.clear();
+    free_blocks.insert(head, 0, size);
+    handles.clear();
     alloc_success = 0;
     alloc_failure = 0;
+    realloc_in_place = 0;
+    realloc_moved = 0;
+    bytes_moved = 0;
+    compaction_runs = 0;
+    compaction_bytes = 0;
+    return true;
 }   
 
-int Memory::allocate(size_t size) {
-    if (!allocator) {
+uint32_t Memory::new_block(size_t start, bool free, uint32_t next) {
+    if (spare != NO_BLOCK) {
+        uint32_t b = spare;
+        spare = blocks[b].next;
+        blocks[b] = Block(start, free, next);
+        return b;
+    }
+
+    if (blocks.size() >= NO_BLOCK)
+        return NO_BLOCK;
+    blocks.push_back(Block(start, free, next));
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void Memory::drop_block(uint32_t b) {
+    blocks[b].next = spare;
+    spare = b;
+}
+
+bool Memory::record_available() const {
+    return spare != NO_BLOCK || blocks.size() < NO_BLOCK;
+}
+
+size_t Memory::size_of(uint32_t b) const {
+    uint32_t next = blocks[b].next;
+    size_t end = (next == NO_BLOCK) ? total_size : blocks[next].start;
+    return end - blocks[b].start;
+}
+
+Handle Memory::allocate(size_t size) {
+    PERF_TIME(PerfOp::MALLOC);
+
+    // a split may need one more record
+    if (!allocator || !record_available()) {
         alloc_failure++;
-        return -1;
+        return INVALID_HANDLE;
     }
 
-    auto it = allocator->select_block(blocks, size);
-    if (it == blocks.end()) {
+    uint32_t b = allocator->select_block(free_blocks, size);
+    PERF_END_SCAN();
+    if (b == NO_BLOCK) {
         alloc_failure++;
-        return -1;
+        return INVALID_HANDLE;
     }
 
-    int id = next_id++;
-
-    if (it->size > size) {
-        Block remaining = {
-            it->start + size,
-            it->size - size,
-            true,
-            -1
-        };
-        it->size = size;
-        blocks.insert(std::next(it), remaining);
+    Handle id = handles.insert(b);
+    if (id == INVALID_HANDLE) {
+        alloc_failure++;
+        return INVALID_HANDLE;
     }
 
-    it->free = false;
-    it->id = id;
+    place(b, size, HandleTable<uint32_t>::slot_of(id));
 
     alloc_success++;
     return id;
 }
 
+void Memory::place(uint32_t b, size_t size, uint32_t slot) {
+    size_t start = blocks[b].start;
+    size_t available = size_of(b);
+    free_blocks.erase(start);
+
+    if (available > size) {
+        uint32_t rest = new_block(start + size, true, blocks[b].next);
+        blocks[b].next = rest;
+        free_blocks.insert(rest, start + size, available - size);
+        PERF_COUNT(splits, 1);
+    }
+
+    blocks[b].free = false;
+    blocks[b].slot = slot;
+    handles.at_slot(slot) = b;
+    used_size += size;
+}
 
 size_t Memory::get_total_memory() const {
     return total_size;
 }
 
 size_t Memory::get_used_memory() const {
-    size_t used = 0;
-    for (const auto& b : blocks)
-        if (!b.free) used += b.size;
-    return used;
+    return used_size;
 }
 
 size_t Memory::get_free_memory() const {
@@ -71,61 +127,310 @@ double Memory::get_utilization() const {
 }
 
 double Memory::get_external_fragmentation() const {
-    size_t total_free = 0;
-    size_t largest_free = 0;
-
-    for (const auto& b : blocks) {
-        if (b.free) {
-            total_free += b.size;
-            largest_free = std::max(largest_free, b.size);
-        }
-    }
+    size_t total_free = get_free_memory();
+    size_t largest_free = free_blocks.largest();
 
     if (total_free == 0) return 0.0;
     return (1.0 - (double)largest_free / total_free) * 100.0;
 }
 
 
-bool Memory::deallocate(int id) {
-    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-        if (!it->free && it->id == id) {
-            it->free = true;
-            it->id = -1;
+bool Memory::deallocate(Handle id) {
+    PERF_TIME(PerfOp::FREE);
+
+    uint32_t b = find_used(id);
+
+    // rejects unknown handles and counts stale ones
+    if (!handles.release(id))
+        return false;
+
+    used_size -= size_of(b);
+    blocks[b].free = true;
+    coalesce(b);
+    return true;
+}
+
+HandleStatus Memory::handle_status(Handle id) const {
+    return handles.status(id);
+}
+
+size_t Memory::get_stale_rejections() const {
+    return handles.get_stale_rejections();
+}
+
+uint32_t Memory::find_used(Handle id) const {
+    PERF_COUNT(lookup_steps, 1);
+    const uint32_t* b = handles.find(id);
+    return b ? *b : NO_BLOCK;
+}
+
+bool Memory::get_block(Handle id, size_t& start, size_t& size) const {
+    const uint32_t* b = handles.find(id);
+    if (!b)
+        return false;
+
+    start = blocks[*b].start;
+    size = size_of(*b);
+    return true;
+}
+
+size_t Memory::get_block_count() const {
+    return handles.size() + free_blocks.size();
+}
+
+size_t Memory::get_free_block_count() const {
+    return free_blocks.size();
+}
+
+size_t Memory::get_metadata_bytes() const {
+    return blocks.size() * sizeof(Block) + handles.memory_bytes() +
+           free_blocks.memory_bytes();
+}
+
+void Memory::coalesce(uint32_t b) {
+    // merge with next
+    uint32_t next = blocks[b].next;
+    if (next != NO_BLOCK && blocks[next].free) {
+        free_blocks.erase(blocks[next].start);
+        blocks[b].next = blocks[next].next;
+        drop_block(next);
+        PERF_COUNT(coalesces, 1);
+    }
+
+    // merge with previous: only a free one matters, and the index finds
+    // it (unless a zero-size block sits in between)
+    uint32_t prev = free_blocks.ending_at(blocks[b].start);
+    if (prev != NO_BLOCK && blocks[prev].next == b) {
+        free_blocks.erase(blocks[prev].start);
+        blocks[prev].next = blocks[b].next;
+        drop_block(b);
+        b = prev;
+        PERF_COUNT(coalesces, 1);
+    }
+
+    free_blocks.insert(b, blocks[b].start, size_of(b));
+}
+
+ReallocResult Memory::reallocate(Handle id, size_t size) {
+    PERF_TIME(PerfOp::REALLOC);
+
+    if (size == 0)
+        return ReallocResult::FAILED;
+
+    uint32_t b = find_used(id);
+    if (b == NO_BLOCK)
+        return ReallocResult::FAILED;
+
+    size_t old_size = size_of(b);
 
-            // merge with next
-            auto next = std::next(it);
-            if (next != blocks.end() && next->free) {
-                it->size += next->size;
-                blocks.erase(next);
+    // shrink: split off the tail and hand it back to the free space
+    if (size <= old_size) {
+        if (size < old_size) {
+            uint32_t tail = new_block(blocks[b].start + size, true, blocks[b].next);
+            if (tail == NO_BLOCK)
+                return ReallocResult::FAILED;
+
+            blocks[b].next = tail;
+            used_size -= old_size - size;
+            coalesce(tail);
+            PERF_COUNT(splits, 1);
+        }
+        realloc_in_place++;
+        return ReallocResult::IN_PLACE;
+    }
+
+    // grow: absorb the front of a large enough free neighbor above
+    size_t extra = size - old_size;
+    uint32_t next = blocks[b].next;
+    if (next != NO_BLOCK && blocks[next].free && size_of(next) >= extra) {
+        size_t next_size = size_of(next);
+        free_blocks.erase(blocks[next].start);
+        if (next_size == extra) {
+            blocks[b].next = blocks[next].next;
+            drop_block(next);
+        } else {
+            blocks[next].start += extra;
+            free_blocks.insert(next, blocks[next].start, next_size - extra);
+        }
+
+        used_size += extra;
+        realloc_in_place++;
+        return ReallocResult::IN_PLACE;
+    }
+
+    // slide down: merge the free neighbor below (and the one above, if
+    // free) and move the contents to its start, memmove-style, since the
+    // old and new ranges may overlap
+    uint32_t prev = free_blocks.ending_at(blocks[b].start);
+    if (prev != NO_BLOCK && blocks[prev].next == b) {
+        bool next_free = next != NO_BLOCK && blocks[next].free;
+        size_t span = size_of(prev) + old_size + (next_free ? size_of(next) : 0);
+
+        if (span >= size) {
+            uint32_t end = next_free ? blocks[next].next : next;
+            free_blocks.erase(blocks[prev].start);
+            if (next_free) {
+                free_blocks.erase(blocks[next].start);
+                drop_block(next);
             }
 
-            // merge with previous
-            if (it != blocks.begin()) {
-                auto prev = std::prev(it);
-                if (prev->free) {
-                    prev->size += it->size;
-                    blocks.erase(it);
-                }
+            // prev's record takes the data, b's record the free tail
+            uint32_t slot = blocks[b].slot;
+            blocks[prev].free = false;
+            blocks[prev].slot = slot;
+            handles.at_slot(slot) = prev;
+
+            size_t tail = span - size;
+            if (tail > 0) {
+                blocks[b].start = blocks[prev].start + size;
+                blocks[b].free = true;
+                blocks[b].next = end;
+                blocks[prev].next = b;
+                free_blocks.insert(b, blocks[b].start, tail);
+                PERF_COUNT(splits, 1);
+            } else {
+                blocks[prev].next = end;
+                drop_block(b);
             }
 
-            return true;
+            bytes_moved += old_size;
+            realloc_moved++;
+            used_size += extra;
+            return ReallocResult::MOVED;
         }
     }
-    return false;
+
+    // relocate: place a new block, then release the old one
+    if (!allocator || !record_available())
+        return ReallocResult::FAILED;
+
+    uint32_t target = allocator->select_block(free_blocks, size);
+    PERF_END_SCAN();
+    if (target == NO_BLOCK)
+        return ReallocResult::FAILED;
+
+    // the handle keeps its slot and generation, only the block changes
+    place(target, size, blocks[b].slot);
+
+    bytes_moved += old_size;
+    realloc_moved++;
+
+    used_size -= old_size;
+    blocks[b].free = true;
+    coalesce(b);
+
+    return ReallocResult::MOVED;
+}
+
+CompactionResult Memory::compact(size_t budget) {
+    CompactionResult result;
+    result.bytes_moved = 0;
+    result.complete = true;
+
+    // rebuilt below for whatever free space is left
+    free_blocks.clear();
+
+    size_t cursor = 0;          // next address a used block can slide down to
+    uint32_t last = NO_BLOCK;   // last block of the compacted prefix
+    uint32_t b = head;
+
+    while (b != NO_BLOCK) {
+        uint32_t next = blocks[b].next;
+
+        if (blocks[b].free) {
+            drop_block(b);
+            b = next;
+            continue;
+        }
+
+        // the next block has not moved yet, so this is still exact
+        size_t size = size_of(b);
+
+        if (blocks[b].start != cursor) {
+            // always move at least one block, or a block larger than the
+            // budget would stall incremental compaction forever
+            if (budget > 0 && !result.relocations.empty() &&
+                result.bytes_moved + size > budget) {
+                result.complete = false;
+                break;
+            }
+
+            result.relocations.push_back({handles.handle_of(blocks[b].slot),
+                                          blocks[b].start, cursor});
+            result.bytes_moved += size;
+            blocks[b].start = cursor;
+        }
+
+        if (last == NO_BLOCK)
+            head = b;
+        else
+            blocks[last].next = b;
+        last = b;
+
+        cursor += size;
+        b = next;
+    }
+
+    // everything between the compacted prefix and the first untouched
+    // block (or the end of memory) becomes a single free block; a free
+    // block was dropped to make that space, so a record is available
+    uint32_t rest = b;
+    size_t gap_end = (b == NO_BLOCK) ? total_size : blocks[b].start;
+    if (gap_end > cursor) {
+        rest = new_block(cursor, true, b);
+        free_blocks.insert(rest, cursor, gap_end - cursor);
+    }
+
+    if (last == NO_BLOCK)
+        head = rest;
+    else
+        blocks[last].next = rest;
+
+    // free blocks past an early stop keep their place
+    for (uint32_t x = b; x != NO_BLOCK; x = blocks[x].next) {
+        if (blocks[x].free)
+            free_blocks.insert(x, blocks[x].start, size_of(x));
+    }
+
+    compaction_runs++;
+    compaction_bytes += result.bytes_moved;
+
+    return result;
+}
+
+size_t Memory::get_compaction_runs() const {
+    return compaction_runs;
+}
+
+size_t Memory::get_compaction_bytes() const {
+    return compaction_bytes;
+}
+
+size_t Memory::get_realloc_in_place() const {
+    return realloc_in_place;
+}
+
+size_t Memory::get_realloc_moved() const {
+    return realloc_moved;
+}
+
+size_t Memory::get_bytes_moved() const {
+    return bytes_moved;
 }
 
 void Memory::dump() const {
-    for (const auto& block : blocks) {
+    for (uint32_t b = head; b != NO_BLOCK; b = blocks[b].next) {
+        const Block& block = blocks[b];
         std::cout << "[0x"
                   << std::hex << std::setw(4) << std::setfill('0') << block.start
                   << " - 0x"
-                  << std::hex << std::setw(4) << (block.start + block.size - 1)
-                  << "] ";
+                  << std::hex << std::setw(4) << (block.start + size_of(b) - 1)
+                  << std::dec << std::setfill(' ') << "] ";
 
         if (block.free) {
             std::cout << "FREE\n";
         } else {
-            std::cout << "USED (id=" << block.id << ")\n";
+            std::cout << "USED (id=" << handles.handle_of(block.slot) << ")\n";
         }
     }
 }
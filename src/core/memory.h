@@ -1,30 +1,99 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
-#include <list>
+#include <deque>
 #include <cstddef>
+#include <cstdint>
 #include "block.h"
+#include "compaction.h"
+#include "free_index.h"
+#include "handle_table.h"
 
 class Allocator;   // forward declaration
 
+enum class ReallocResult {
+    FAILED,
+    IN_PLACE,
+    MOVED
+};
+
 class Memory {
 private:
     size_t total_size;
-    std::list<Block> blocks;
-    int next_id;
+    size_t used_size;
+
+    // block records, linked in address order from `head`; records freed
+    // by merges are reused through the `spare` chain
+    std::deque<Block> blocks;
+    uint32_t head;
+    uint32_t spare;
+
+    FreeIndex free_blocks;
+    HandleTable<uint32_t> handles;
     Allocator* allocator;
     size_t alloc_success;
     size_t alloc_failure;
 
+    // realloc cost accounting
+    size_t realloc_in_place;
+    size_t realloc_moved;
+    size_t bytes_moved;
+
+    // compaction cost accounting
+    size_t compaction_runs;
+    size_t compaction_bytes;
+
+    // block record of a live handle, or NO_BLOCK
+    uint32_t find_used(Handle id) const;
+
+    size_t size_of(uint32_t b) const;
+
+    // a record for a new block, or NO_BLOCK once 2^32 - 1 are in use
+    uint32_t new_block(size_t start, bool free, uint32_t next);
+    void drop_block(uint32_t b);
+    bool record_available() const;
+
+    // take the front `size` bytes of free block b for a handle slot,
+    // splitting the rest off as a new free block
+    void place(uint32_t b, size_t size, uint32_t slot);
+
+    // merge a free, unindexed block with free neighbors on both sides
+    // and index the result
+    void coalesce(uint32_t b);
 
 public:
     Memory();
 
-    void init(size_t size);
+    // false if size exceeds MAX_MEMORY_SIZE
+    bool init(size_t size);
     void set_allocator(Allocator* alloc);
 
-    int allocate(size_t size);
-    bool deallocate(int id);
+    // returns a generation-tagged handle, or INVALID_HANDLE on failure
+    Handle allocate(size_t size);
+
+    // false for unknown handles and for stale ones (use-after-free,
+    // double free); handle_status() tells the two apart
+    bool deallocate(Handle id);
+    HandleStatus handle_status(Handle id) const;
+    size_t get_stale_rejections() const;
+
+    // resize a block, in place when possible, relocating otherwise;
+    // on failure the block is left untouched
+    ReallocResult reallocate(Handle id, size_t size);
+
+    // slide used blocks toward address 0 in one pass, merging the free
+    // space behind them; budget > 0 caps the bytes moved per call, but at
+    // least one block is moved so repeated calls always make progress
+    CompactionResult compact(size_t budget = 0);
+
+    // start and size of the used block with the given id; false if none
+    bool get_block(Handle id, size_t& start, size_t& size) const;
+
+    size_t get_block_count() const;
+    size_t get_free_block_count() const;
+
+    // bytes held by block records, the handle table and the free index
+    size_t get_metadata_bytes() const;
 
     void dump() const;
     size_t get_total_memory() const;
@@ -33,6 +102,12 @@ public:
     double get_external_fragmentation() const;
     double get_utilization() const;
 
+    size_t get_realloc_in_place() const;
+    size_t get_realloc_moved() const;
+    size_t get_bytes_moved() const;
+    size_t get_compaction_runs() const;
+    size_t get_compaction_bytes() const;
+
 };
 
 #endif
@@ -0,0 +1,71 @@
+#include "memory_bench.h"
+#include "memory.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+MemoryBenchResult run_memory_soak(Allocator* policy,
+                                  size_t blocks,
+                                  size_t churn,
+                                  unsigned seed) {
+    MemoryBenchResult result = {0, 0, 0.0, 0.0, 0, 0, 0.0};
+
+    // room for every block at the largest size, so the fill never fails
+    // for lack of space and churn still fragments
+    const size_t MIN_SIZE = 16;
+    const size_t MAX_SIZE = 256;
+
+    Memory mem;
+    if (blocks == 0 || blocks > MAX_MEMORY_SIZE / MAX_SIZE || !mem.init(blocks * MAX_SIZE))
+        return result;
+    mem.set_allocator(policy);
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> size_dist(MIN_SIZE, MAX_SIZE);
+
+    std::vector<Handle> live;
+    live.reserve(blocks);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < blocks; ++i) {
+        Handle id = mem.allocate(size_dist(rng));
+        if (id == INVALID_HANDLE)
+            result.failures++;
+        else
+            live.push_back(id);
+    }
+
+    auto filled = std::chrono::steady_clock::now();
+    result.blocks = live.size();
+
+    for (size_t i = 0; i < churn; ++i) {
+        if (!live.empty() && (live.size() >= blocks || rng() % 2 == 0)) {
+            size_t idx = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+            mem.deallocate(live[idx]);
+            live[idx] = live.back();
+            live.pop_back();
+        } else {
+            Handle id = mem.allocate(size_dist(rng));
+            if (id == INVALID_HANDLE)
+                result.failures++;
+            else
+                live.push_back(id);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    double fill_seconds = std::chrono::duration<double>(filled - begin).count();
+    double churn_seconds = std::chrono::duration<double>(end - filled).count();
+
+    result.fill_ops_per_sec = fill_seconds > 0 ? blocks / fill_seconds : 0.0;
+    result.churn_ops_per_sec = churn_seconds > 0 ? churn / churn_seconds : 0.0;
+    result.total_blocks = mem.get_block_count();
+    result.metadata_bytes = mem.get_metadata_bytes();
+    result.bytes_per_block = result.total_blocks > 0
+                                 ? (double)result.metadata_bytes / result.total_blocks
+                                 : 0.0;
+
+    return result;
+}
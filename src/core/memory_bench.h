@@ -0,0 +1,26 @@
+#ifndef MEMORY_BENCH_H
+#define MEMORY_BENCH_H
+
+#include <cstddef>
+
+class Allocator;
+
+struct MemoryBenchResult {
+    size_t blocks;            // live blocks after the fill
+    size_t failures;
+    double fill_ops_per_sec;  // mallocs building the heap
+    double churn_ops_per_sec; // free + malloc pairs at full size, per op
+    size_t total_blocks;      // used + free blocks at the end
+    size_t metadata_bytes;    // Memory's block, handle and free-index tables
+    double bytes_per_block;   // metadata_bytes / total_blocks
+};
+
+// soak a fresh Memory: malloc `blocks` blocks of 16-256 bytes one at a
+// time, then replay `churn` ops that free a random live block or malloc
+// a new one, keeping the heap at about that size
+MemoryBenchResult run_memory_soak(Allocator* policy,
+                                  size_t blocks,
+                                  size_t churn,
+                                  unsigned seed);
+
+#endif
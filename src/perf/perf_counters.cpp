@@ -0,0 +1,187 @@
+#include "perf_counters.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <mutex>
+
+#if defined(MEMSIM_RDTSC) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PERF_USE_RDTSC 1
+#else
+#define PERF_USE_RDTSC 0
+#endif
+
+namespace {
+
+thread_local PerfCounters counters = PerfCounters();
+
+// flushed totals from every thread
+std::mutex total_mutex;
+PerfCounters total = PerfCounters();
+
+const char* op_names[] = {
+    "malloc", "free", "realloc", "buddy_malloc", "buddy_free", "buddy_realloc"
+};
+
+void dump_histogram_json(std::ostream& out, const Log2Histogram& h) {
+    out << "{\"count\": " << h.count
+        << ", \"sum\": " << h.sum
+        << ", \"max\": " << h.max
+        << ", \"buckets\": [";
+    bool first = true;
+    for (int k = 0; k < 65; ++k) {
+        if (h.buckets[k] == 0)
+            continue;
+        uint64_t below = k == 0 ? 1 : (k == 64 ? UINT64_MAX : (1ULL << k));
+        out << (first ? "" : ", ")
+            << "{\"lt\": " << below << ", \"count\": " << h.buckets[k] << "}";
+        first = false;
+    }
+    out << "]}";
+}
+
+void dump_histogram(std::ostream& out, const char* name, const Log2Histogram& h) {
+    out << name << ": count " << h.count;
+    if (h.count > 0)
+        out << ", mean " << (double)h.sum / h.count << ", max " << h.max;
+    out << "\n";
+    for (int k = 0; k < 65; ++k) {
+        if (h.buckets[k] == 0)
+            continue;
+        out << "  < " << (k == 0 ? 1 : (k == 64 ? UINT64_MAX : (1ULL << k)))
+            << ": " << h.buckets[k] << "\n";
+    }
+}
+
+} // anonymous namespace
+
+void Log2Histogram::add(uint64_t value) {
+    int bucket = 0;
+    for (uint64_t v = value; v != 0; v >>= 1)
+        bucket++;
+
+    buckets[bucket]++;
+    count++;
+    sum += value;
+    if (value > max)
+        max = value;
+}
+
+void Log2Histogram::merge(const Log2Histogram& other) {
+    for (int k = 0; k < 65; ++k)
+        buckets[k] += other.buckets[k];
+    count += other.count;
+    sum += other.sum;
+    if (other.max > max)
+        max = other.max;
+}
+
+void PerfCounters::merge(const PerfCounters& other) {
+    for (int i = 0; i < static_cast<int>(PerfOp::COUNT); ++i)
+        op_time[i].merge(other.op_time[i]);
+
+    nodes_scanned.merge(other.nodes_scanned);
+    lookup_steps += other.lookup_steps;
+    splits += other.splits;
+    coalesces += other.coalesces;
+
+    buddy_splits += other.buddy_splits;
+    buddy_merges += other.buddy_merges;
+    buddy_lookups += other.buddy_lookups;
+    order_searches += other.order_searches;
+}
+
+PerfCounters& perf_counters() {
+    return counters;
+}
+
+void perf_reset() {
+    std::lock_guard<std::mutex> lock(total_mutex);
+    counters = PerfCounters();
+    total = PerfCounters();
+}
+
+void perf_flush() {
+    {
+        std::lock_guard<std::mutex> lock(total_mutex);
+        total.merge(counters);
+    }
+
+    uint32_t depth = counters.timer_depth;
+    counters = PerfCounters();
+    counters.timer_depth = depth;
+}
+
+const char* perf_timer_unit() {
+    return PERF_USE_RDTSC ? "cycles" : "ns";
+}
+
+uint64_t perf_now() {
+#if PERF_USE_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void perf_dump(std::ostream& out, const std::vector<size_t>& free_list_lengths) {
+    perf_flush();
+    std::lock_guard<std::mutex> lock(total_mutex);
+    const PerfCounters& c = total;
+
+    for (int i = 0; i < static_cast<int>(PerfOp::COUNT); ++i) {
+        if (c.op_time[i].count == 0)
+            continue;
+        std::string name = std::string(op_names[i]) + " time (" + perf_timer_unit() + ")";
+        dump_histogram(out, name.c_str(), c.op_time[i]);
+    }
+
+    dump_histogram(out, "Nodes scanned per select_block", c.nodes_scanned);
+    out << "Id lookup steps: " << c.lookup_steps << "\n";
+    out << "Splits: " << c.splits << "\n";
+    out << "Coalesces: " << c.coalesces << "\n";
+    out << "Buddy splits: " << c.buddy_splits << "\n";
+    out << "Buddy merges: " << c.buddy_merges << "\n";
+    out << "Buddy lookup steps: " << c.buddy_lookups << "\n";
+    out << "Buddy order searches: " << c.order_searches << "\n";
+
+    if (!free_list_lengths.empty()) {
+        out << "Buddy free list lengths:";
+        for (size_t len : free_list_lengths)
+            out << " " << len;
+        out << "\n";
+    }
+}
+
+void perf_dump_json(std::ostream& out, const std::vector<size_t>& free_list_lengths) {
+    perf_flush();
+    std::lock_guard<std::mutex> lock(total_mutex);
+    const PerfCounters& c = total;
+
+    out << "{\n  \"timer_unit\": \"" << perf_timer_unit() << "\",\n";
+
+    out << "  \"op_time\": {";
+    for (int i = 0; i < static_cast<int>(PerfOp::COUNT); ++i) {
+        out << (i == 0 ? "\n" : ",\n") << "    \"" << op_names[i] << "\": ";
+        dump_histogram_json(out, c.op_time[i]);
+    }
+    out << "\n  },\n";
+
+    out << "  \"nodes_scanned\": ";
+    dump_histogram_json(out, c.nodes_scanned);
+    out << ",\n";
+
+    out << "  \"lookup_steps\": " << c.lookup_steps << ",\n"
+        << "  \"splits\": " << c.splits << ",\n"
+        << "  \"coalesces\": " << c.coalesces << ",\n"
+        << "  \"buddy_splits\": " << c.buddy_splits << ",\n"
+        << "  \"buddy_merges\": " << c.buddy_merges << ",\n"
+        << "  \"buddy_lookups\": " << c.buddy_lookups << ",\n"
+        << "  \"order_searches\": " << c.order_searches << ",\n";
+
+    out << "  \"buddy_free_list_lengths\": [";
+    for (size_t k = 0; k < free_list_lengths.size(); ++k)
+        out << (k == 0 ? "" : ", ") << free_list_lengths[k];
+    out << "]\n}\n";
+}
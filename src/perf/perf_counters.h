@@ -0,0 +1,117 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+// Hot-path instrumentation. Build with -DMEMSIM_INSTRUMENT (make
+// INSTRUMENT=1, or INSTRUMENT=rdtsc for cycle timings on x86-64) to
+// enable it; otherwise every PERF_* macro expands to nothing.
+// Counters are thread_local, so parallel sweep runs never contend on
+// them; PERF_FLUSH() folds the calling thread's counts into a global
+// total, which is what perf_dump reports.
+
+enum class PerfOp {
+    MALLOC,
+    FREE,
+    REALLOC,
+    BUDDY_MALLOC,
+    BUDDY_FREE,
+    BUDDY_REALLOC,
+    COUNT
+};
+
+// bucket k counts samples v with 2^(k-1) <= v < 2^k (bucket 0: v == 0)
+struct Log2Histogram {
+    uint64_t buckets[65];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    void add(uint64_t value);
+    void merge(const Log2Histogram& other);
+};
+
+struct PerfCounters {
+    Log2Histogram op_time[static_cast<int>(PerfOp::COUNT)];
+
+    // Memory + FF/BF/WF
+    uint64_t scan_steps;          // running count for the current select_block
+    Log2Histogram nodes_scanned;  // blocks visited per select_block call
+    uint64_t lookup_steps;        // blocks visited resolving ids
+    uint64_t splits;
+    uint64_t coalesces;
+
+    // BuddyAllocator
+    uint64_t buddy_splits;
+    uint64_t buddy_merges;
+    uint64_t buddy_lookups;       // free-list entries visited finding buddies
+    uint64_t order_searches;      // orders probed looking for a free block
+
+    // nesting of live PerfTimers; only the outermost one records, so a
+    // realloc that calls malloc/free counts as one op. not merged
+    uint32_t timer_depth;
+
+    void merge(const PerfCounters& other);
+};
+
+PerfCounters& perf_counters();
+void perf_reset();
+
+// add this thread's counters to the global total and zero them
+void perf_flush();
+
+const char* perf_timer_unit();
+uint64_t perf_now();
+
+// text summary and JSON dump; free_list_lengths[k] is the current buddy
+// free list length of order k (may be empty)
+void perf_dump(std::ostream& out, const std::vector<size_t>& free_list_lengths);
+void perf_dump_json(std::ostream& out, const std::vector<size_t>& free_list_lengths);
+
+#ifdef MEMSIM_INSTRUMENT
+
+class PerfTimer {
+private:
+    PerfOp op;
+    uint64_t start;
+    bool outermost;
+
+public:
+    explicit PerfTimer(PerfOp o)
+        : op(o), start(0), outermost(perf_counters().timer_depth++ == 0) {
+        if (outermost)
+            start = perf_now();
+    }
+    ~PerfTimer() {
+        PerfCounters& c = perf_counters();
+        c.timer_depth--;
+        if (outermost)
+            c.op_time[static_cast<int>(op)].add(perf_now() - start);
+    }
+};
+
+#define PERF_ENABLED 1
+#define PERF_COUNT(field, n) (perf_counters().field += (n))
+#define PERF_TIME(op) PerfTimer perf_timer_(op)
+#define PERF_FLUSH() perf_flush()
+#define PERF_END_SCAN()                                              \
+    do {                                                             \
+        PerfCounters& pc_ = perf_counters();                         \
+        pc_.nodes_scanned.add(pc_.scan_steps);                       \
+        pc_.scan_steps = 0;                                          \
+    } while (0)
+
+#else
+
+#define PERF_ENABLED 0
+#define PERF_COUNT(field, n) ((void)0)
+#define PERF_TIME(op) ((void)0)
+#define PERF_FLUSH() ((void)0)
+#define PERF_END_SCAN() ((void)0)
+
+#endif
+
+#endif
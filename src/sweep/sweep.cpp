@@ -0,0 +1,189 @@
+#include "sweep.h"
+#include "thread_pool.h"
+#include "../perf/perf_counters.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::vector<std::string> split(const std::string& list, char sep) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty())
+            items.push_back(item);
+    }
+    return items;
+}
+
+bool is_power_of_two(size_t x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+} // anonymous namespace
+
+bool set_sweep_option(SweepConfig& config, const std::string& option) {
+    size_t eq = option.find('=');
+    if (eq == std::string::npos)
+        return false;
+
+    std::string key = option.substr(0, eq);
+    std::string value = option.substr(eq + 1);
+
+    try {
+        if (key == "policies") {
+            config.policies.clear();
+            for (const auto& name : split(value, ',')) {
+                if (name == "first_fit") config.policies.push_back(PlacementPolicy::FIRST_FIT);
+                else if (name == "best_fit") config.policies.push_back(PlacementPolicy::BEST_FIT);
+                else if (name == "worst_fit") config.policies.push_back(PlacementPolicy::WORST_FIT);
+                else if (name == "buddy") config.policies.push_back(PlacementPolicy::BUDDY);
+                else return false;
+            }
+        }
+        else if (key == "sizes") {
+            config.memory_sizes.clear();
+            for (const auto& size : split(value, ','))
+                config.memory_sizes.push_back(std::stoull(size));
+        }
+        else if (key == "caches") {
+            config.caches.clear();
+            for (const auto& spec : split(value, ',')) {
+                CacheConfig cache;
+                if (!parse_cache_config(spec, cache))
+                    return false;
+                config.caches.push_back(cache);
+            }
+        }
+        else if (key == "seeds") {
+            config.seeds.clear();
+            for (const auto& seed : split(value, ','))
+                config.seeds.push_back(std::stoull(seed));
+        }
+        else if (key == "threads") {
+            config.threads = static_cast<unsigned>(std::stoul(value));
+        }
+        else {
+            return set_workload_option(config.workload, option);
+        }
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<SweepResult> run_sweep(const SweepConfig& config,
+                                   const MappedTrace* trace) {
+    std::vector<SweepResult> results;
+
+    // a trace is fixed, so the seed axis collapses to a single point
+    std::vector<uint64_t> seeds = config.seeds;
+    if (trace || seeds.empty())
+        seeds = {trace ? 0 : config.workload.seed};
+
+    for (PlacementPolicy policy : config.policies) {
+        for (size_t memory_size : config.memory_sizes) {
+            if (policy == PlacementPolicy::BUDDY && !is_power_of_two(memory_size))
+                continue;
+            for (const CacheConfig& cache : config.caches) {
+                for (uint64_t seed : seeds) {
+                    SweepResult r{};
+                    r.policy = policy;
+                    r.memory_size = memory_size;
+                    r.cache = cache;
+                    r.seed = seed;
+                    r.seconds = 0.0;
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    // each task owns its slot in results; only the trace is shared
+    ThreadPool pool(config.threads);
+
+    for (SweepResult& slot : results) {
+        SweepResult* r = &slot;
+        pool.submit([r, trace, &config] {
+            auto begin = std::chrono::steady_clock::now();
+
+            TraceRunner runner(r->policy, r->memory_size, r->cache);
+            TraceOp op;
+
+            if (trace) {
+                MappedTraceCursor cursor(*trace);
+                while (cursor.next(op))
+                    runner.apply(op);
+            } else {
+                WorkloadConfig workload = config.workload;
+                workload.seed = r->seed;
+                WorkloadGenerator generator(workload);
+                while (generator.next(op))
+                    runner.apply(op);
+            }
+
+            r->locality = runner.result();
+            r->seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+
+            // worker counters are thread_local; fold them into perf's total
+            PERF_FLUSH();
+        });
+    }
+
+    pool.wait();
+    return results;
+}
+
+bool write_sweep_csv(const std::string& path,
+                     const std::vector<SweepResult>& results,
+                     bool from_trace) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    // one miss-rate column per level name across all configs, in order of
+    // first appearance; blank where a config has no such level
+    std::vector<std::string> names;
+    for (const auto& r : results)
+        for (const auto& level : r.locality.levels)
+            if (std::none_of(names.begin(), names.end(), [&](const std::string& n) {
+                    return same_level_name(n, level.name);
+                }))
+                names.push_back(level.name);
+
+    out << "policy,memory_size,cache,seed,accesses,dropped_accesses,failed_allocs,";
+    for (const auto& name : names)
+        out << name << "_miss_rate,";
+    out << "memory_rate,fragmentation,seconds\n";
+
+    for (const auto& r : results) {
+        const LocalityResult& l = r.locality;
+        out << policy_name(r.policy) << ","
+            << r.memory_size << ","
+            << format_cache_config(r.cache) << ",";
+        if (from_trace)
+            out << "trace";
+        else
+            out << r.seed;
+        out << "," << l.accesses
+            << "," << l.dropped_accesses
+            << "," << l.failed_allocs;
+        for (const auto& name : names) {
+            out << ",";
+            for (const auto& level : l.levels)
+                if (same_level_name(level.name, name))
+                    out << level.miss_rate;
+        }
+        out << "," << l.memory_rate
+            << "," << l.fragmentation
+            << "," << r.seconds
+            << "\n";
+    }
+
+    return !out.fail();
+}
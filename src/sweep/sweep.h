@@ -0,0 +1,48 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "../analysis/locality.h"
+#include "../cache/cache_config.h"
+#include "../workload/workload_generator.h"
+#include "../trace/mapped_trace.h"
+
+// grid of independent simulations:
+// policy x memory size x cache geometry x workload seed
+struct SweepConfig {
+    std::vector<PlacementPolicy> policies;
+    std::vector<size_t> memory_sizes;
+    std::vector<CacheConfig> caches;
+    std::vector<uint64_t> seeds;     // ignored when replaying a trace
+
+    WorkloadConfig workload;         // used when no trace is given
+    unsigned threads;                // 0 = all cores
+};
+
+struct SweepResult {
+    PlacementPolicy policy;
+    size_t memory_size;
+    CacheConfig cache;
+    uint64_t seed;
+    LocalityResult locality;
+    double seconds;
+};
+
+// runs every grid point on a work-stealing pool; trace may be null, in
+// which case each point generates its workload in-process from its seed.
+// buddy points with a non power-of-two memory size are skipped
+std::vector<SweepResult> run_sweep(const SweepConfig& config,
+                                   const MappedTrace* trace);
+
+// apply a "key=value" grid option (policies, sizes, caches, seeds,
+// threads) or fall back to a workload option
+bool set_sweep_option(SweepConfig& config, const std::string& option);
+
+bool write_sweep_csv(const std::string& path,
+                     const std::vector<SweepResult>& results,
+                     bool from_trace);
+
+#endif
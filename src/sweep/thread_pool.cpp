@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned threads)
+    : queued(0), pending(0), stopping(false), next_queue(0)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i)
+        queues.emplace_back(new WorkQueue());
+
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        target = next_queue++ % queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        queued++;
+        pending++;
+    }
+    work_ready.notify_one();
+}
+
+bool ThreadPool::try_pop(size_t self, std::function<void()>& task) {
+    // own queue first, newest task
+    {
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest task from the next non-empty victim
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkQueue& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(state_lock);
+            work_ready.wait(guard, [this] { return stopping || queued > 0; });
+            if (queued == 0)
+                return;     // stopping and nothing left to run
+            queued--;
+        }
+
+        // submit pushes before counting, so the reserved task is already
+        // in some queue; another worker may only take it on its own
+        // reservation, leaving one for us
+        std::function<void()> task;
+        while (!try_pop(self, task))
+            std::this_thread::yield();
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            if (--pending == 0)
+                all_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(state_lock);
+    all_done.wait(guard, [this] { return pending == 0; });
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <cstddef>
+
+// fixed-size pool with one task deque per worker: a worker pops its own
+// newest task and, when empty, steals the oldest task of another worker
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex lock;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex state_lock;
+    std::condition_variable work_ready;
+    std::condition_variable all_done;
+    size_t queued;      // submitted, not yet taken by a worker
+    size_t pending;     // submitted, not yet finished
+    bool stopping;
+    size_t next_queue;
+
+    bool try_pop(size_t self, std::function<void()>& task);
+    void worker_loop(size_t self);
+
+public:
+    // threads == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // block until every submitted task has finished
+    void wait();
+
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "mapped_trace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedTrace::MappedTrace()
+    : records(nullptr), count(0), expected(0), mapping(nullptr), mapping_size(0) {}
+
+MappedTrace::~MappedTrace() {
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mapping_size);
+#endif
+}
+
+bool MappedTrace::open(const std::string& path) {
+    TraceReader probe;
+    if (!probe.open(path)) {
+        error = probe.get_error();
+        return false;
+    }
+
+#ifndef _WIN32
+    {
+        if (probe.is_binary()) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t)st.st_size < TRACE_HEADER_SIZE) {
+                ::close(fd);
+                return false;
+            }
+
+            mapping_size = static_cast<size_t>(st.st_size);
+            mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                return false;
+            }
+
+            // the header count is authoritative; extra bytes are ignored
+            records = static_cast<const unsigned char*>(mapping) + TRACE_HEADER_SIZE;
+            expected = probe.get_header_count();
+            count = (mapping_size - TRACE_HEADER_SIZE) / TRACE_RECORD_SIZE;
+            if (count > expected)
+                count = static_cast<size_t>(expected);
+            return true;
+        }
+    }
+#endif
+
+    // text traces (and binary traces where mmap is unavailable) are
+    // decoded once into an owned buffer with the same record layout
+    TraceOp op;
+    while (probe.next(op)) {
+        size_t pos = owned.size();
+        owned.resize(pos + TRACE_RECORD_SIZE);
+        encode_trace_op(op, owned.data() + pos);
+    }
+
+    records = owned.data();
+    count = owned.size() / TRACE_RECORD_SIZE;
+    expected = probe.is_binary() ? probe.get_header_count() : count;
+    return true;
+}
+
+const std::string& MappedTrace::get_error() const {
+    return error;
+}
+
+size_t MappedTrace::size() const {
+    return count;
+}
+
+uint64_t MappedTrace::expected_size() const {
+    return expected;
+}
+
+bool MappedTrace::is_truncated() const {
+    return count < expected;
+}
+
+TraceOp MappedTrace::at(size_t index) const {
+    return decode_trace_op(records + index * TRACE_RECORD_SIZE);
+}
+
+MappedTraceCursor::MappedTraceCursor(const MappedTrace& t)
+    : trace(t), pos(0) {}
+
+bool MappedTraceCursor::next(TraceOp& op) {
+    if (pos >= trace.size())
+        return false;
+    op = trace.at(pos++);
+    return true;
+}
+
+void MappedTraceCursor::rewind() {
+    pos = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef MAPPED_TRACE_H
+#define MAPPED_TRACE_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "trace.h"
+
+// a whole trace held read-only in memory so many threads can replay it
+// at once: binary traces are mmapped, text traces are parsed once into
+// the binary record layout
+class MappedTrace {
+private:
+    const unsigned char* records;
+    size_t count;
+    uint64_t expected;
+    std::string error;
+
+    void* mapping;
+    size_t mapping_size;
+    std::vector<unsigned char> owned;
+
+public:
+    MappedTrace();
+    ~MappedTrace();
+
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    // false on the same errors as TraceReader::open
+    bool open(const std::string& path);
+    const std::string& get_error() const;
+
+    size_t size() const;
+    // header op count for binary traces, size() for text traces
+    uint64_t expected_size() const;
+    bool is_truncated() const;
+    TraceOp at(size_t index) const;
+};
+
+// independent read position over a shared MappedTrace
+class MappedTraceCursor : public TraceSource {
+private:
+    const MappedTrace& trace;
+    size_t pos;
+
+public:
+    explicit MappedTraceCursor(const MappedTrace& trace);
+
+    bool next(TraceOp& op) override;
+    void rewind() override;
+};
+
+#endif
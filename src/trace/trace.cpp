@@ -0,0 +1,211 @@
+#include "trace.h"
+#include <sstream>
+#include <cstring>
+
+namespace {
+
+const size_t BUFFER_RECORDS = 4096;
+
+void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i)
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+} // anonymous namespace
+
+void encode_trace_op(const TraceOp& op, unsigned char* record) {
+    uint64_t word = (static_cast<uint64_t>(op.type) << 62) |
+                    (op.id & ((1ULL << 62) - 1));
+    put_u64(record, word);
+    put_u64(record + 8, op.arg);
+}
+
+TraceOp decode_trace_op(const unsigned char* record) {
+    uint64_t word = get_u64(record);
+    TraceOp op;
+    op.type = static_cast<TraceOpType>(word >> 62);
+    op.id = word & ((1ULL << 62) - 1);
+    op.arg = get_u64(record + 8);
+    return op;
+}
+
+// ------------------ TraceReader ------------------
+
+TraceReader::TraceReader()
+    : binary(false), next_id(1), buffer_pos(0), buffer_len(0),
+      header_count(0), records_read(0), truncated(false) {}
+
+bool TraceReader::open(const std::string& path) {
+    error.clear();
+    in.open(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    unsigned char header[TRACE_HEADER_SIZE];
+    in.read(reinterpret_cast<char*>(header), TRACE_HEADER_SIZE);
+    size_t got = static_cast<size_t>(in.gcount());
+    binary = got >= 4 && std::memcmp(header, TRACE_MAGIC, 4) == 0;
+
+    if (binary) {
+        if (got < TRACE_HEADER_SIZE) {
+            error = "truncated trace header";
+            in.close();
+            return false;
+        }
+
+        uint32_t version = static_cast<uint32_t>(get_u64(header + 4) & 0xffffffffu);
+        if (version != TRACE_VERSION) {
+            error = "unsupported trace version " + std::to_string(version);
+            in.close();
+            return false;
+        }
+        header_count = get_u64(header + 8);
+    }
+
+    rewind();
+    return true;
+}
+
+const std::string& TraceReader::get_error() const { return error; }
+bool TraceReader::is_binary() const { return binary; }
+uint64_t TraceReader::get_header_count() const { return header_count; }
+uint64_t TraceReader::get_records_read() const { return records_read; }
+bool TraceReader::is_truncated() const { return truncated; }
+
+void TraceReader::rewind() {
+    in.clear();
+    in.seekg(binary ? TRACE_HEADER_SIZE : 0);
+    next_id = 1;
+    buffer_pos = buffer_len = 0;
+    records_read = 0;
+    truncated = false;
+}
+
+bool TraceReader::next(TraceOp& op) {
+    if (binary) {
+        if (records_read == header_count)
+            return false;
+
+        if (buffer_pos == buffer_len) {
+            buffer.resize(BUFFER_RECORDS * TRACE_RECORD_SIZE);
+            in.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+            buffer_len = static_cast<size_t>(in.gcount()) / TRACE_RECORD_SIZE
+                         * TRACE_RECORD_SIZE;
+            buffer_pos = 0;
+            if (buffer_len == 0) {
+                truncated = true;
+                return false;
+            }
+        }
+        op = decode_trace_op(buffer.data() + buffer_pos);
+        buffer_pos += TRACE_RECORD_SIZE;
+        records_read++;
+        return true;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string cmd;
+        ss >> cmd;
+
+        if (cmd == "malloc") {
+            size_t size;
+            if (ss >> size) {
+                op = {TraceOpType::MALLOC, next_id++, size};
+                records_read++;
+                return true;
+            }
+        }
+        else if (cmd == "free") {
+            uint64_t id;
+            if (ss >> id) {
+                op = {TraceOpType::FREE, id, 0};
+                records_read++;
+                return true;
+            }
+        }
+        else if (cmd == "access") {
+            uint64_t id;
+            size_t offset;
+            if (ss >> id >> offset) {
+                op = {TraceOpType::ACCESS, id, offset};
+                records_read++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// ------------------ TraceWriter ------------------
+
+TraceWriter::TraceWriter() : count(0) {}
+
+bool TraceWriter::open(const std::string& path) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    // header is rewritten with the final count on close
+    unsigned char header[TRACE_HEADER_SIZE] = {0};
+    std::memcpy(header, TRACE_MAGIC, 4);
+    header[4] = static_cast<unsigned char>(TRACE_VERSION);
+    out.write(reinterpret_cast<const char*>(header), TRACE_HEADER_SIZE);
+
+    buffer.clear();
+    buffer.reserve(BUFFER_RECORDS * TRACE_RECORD_SIZE);
+    count = 0;
+    return true;
+}
+
+void TraceWriter::write(const TraceOp& op) {
+    size_t pos = buffer.size();
+    buffer.resize(pos + TRACE_RECORD_SIZE);
+    encode_trace_op(op, buffer.data() + pos);
+    count++;
+
+    if (buffer.size() >= BUFFER_RECORDS * TRACE_RECORD_SIZE)
+        flush();
+}
+
+void TraceWriter::flush() {
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    buffer.clear();
+}
+
+bool TraceWriter::close() {
+    flush();
+
+    unsigned char count_bytes[8];
+    put_u64(count_bytes, count);
+    out.seekp(8);
+    out.write(reinterpret_cast<const char*>(count_bytes), 8);
+
+    out.close();
+    return !out.fail();
+}
+
+uint64_t TraceWriter::get_count() const {
+    return count;
+}
+
+bool load_trace(const std::string& path, std::vector<TraceOp>& ops) {
+    TraceReader reader;
+    if (!reader.open(path))
+        return false;
+
+    TraceOp op;
+    while (reader.next(op))
+        ops.push_back(op);
+    return !reader.is_truncated();
+}
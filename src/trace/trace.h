@@ -0,0 +1,102 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+
+enum class TraceOpType {
+    MALLOC,   // arg = size, id = trace-assigned block id
+    FREE,     // id = block to free
+    ACCESS    // id = block, arg = byte offset inside it
+};
+
+struct TraceOp {
+    TraceOpType type;
+    uint64_t id;
+    size_t arg;
+};
+
+// a rewindable stream of trace ops (file reader, generator, ...)
+class TraceSource {
+public:
+    virtual ~TraceSource() = default;
+
+    virtual bool next(TraceOp& op) = 0;   // false at end of stream
+    virtual void rewind() = 0;
+};
+
+// Binary replay format (little-endian):
+//   header: "MSTR" magic, uint32 version, uint64 op count
+//   record: uint64 (type << 62 | id), uint64 arg   -- 16 bytes per op
+const char TRACE_MAGIC[4] = {'M', 'S', 'T', 'R'};
+const uint32_t TRACE_VERSION = 1;
+const size_t TRACE_HEADER_SIZE = 16;
+const size_t TRACE_RECORD_SIZE = 16;
+
+void encode_trace_op(const TraceOp& op, unsigned char* record);
+TraceOp decode_trace_op(const unsigned char* record);
+
+// streams ops from a binary trace or a text trace: "malloc <size>",
+// "free <id>", "access <id> <offset>". text malloc lines get ids 1, 2,
+// 3, ... in order, like the REPL; blank lines, '#' comments and other
+// REPL commands are skipped so test scripts can be replayed as traces.
+// binary traces stop at the header's op count; a file holding fewer
+// records is reported through is_truncated()
+class TraceReader : public TraceSource {
+private:
+    std::ifstream in;
+    bool binary;
+    uint64_t next_id;
+    std::vector<unsigned char> buffer;
+    size_t buffer_pos;
+    size_t buffer_len;
+
+    uint64_t header_count;
+    uint64_t records_read;
+    bool truncated;
+    std::string error;
+
+public:
+    TraceReader();
+
+    // false if the file cannot be read, or is a binary trace with a short
+    // header or an unknown version; get_error() says which
+    bool open(const std::string& path);
+    const std::string& get_error() const;
+
+    bool is_binary() const;
+    uint64_t get_header_count() const;   // binary only
+    uint64_t get_records_read() const;   // since the last rewind
+    bool is_truncated() const;           // EOF came before the header count
+
+    bool next(TraceOp& op) override;
+    void rewind() override;
+};
+
+// buffered writer for the binary format
+class TraceWriter {
+private:
+    std::ofstream out;
+    std::vector<unsigned char> buffer;
+    uint64_t count;
+
+    void flush();
+
+public:
+    TraceWriter();
+
+    bool open(const std::string& path);
+    void write(const TraceOp& op);
+    bool close();
+
+    uint64_t get_count() const;
+};
+
+// read a whole trace (either format) into memory; false if it cannot be
+// opened or a binary trace is truncated
+bool load_trace(const std::string& path, std::vector<TraceOp>& ops);
+
+#endif
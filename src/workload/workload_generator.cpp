@@ -0,0 +1,325 @@
+#include "workload_generator.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+const size_t WORD_SIZE = 8;
+
+// cheap 64-bit mixer used to derive pointer-chasing successors
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+} // anonymous namespace
+
+WorkloadConfig::WorkloadConfig()
+    : seed(1),
+      ops(100000),
+      size_dist(SizeDistribution::UNIFORM),
+      min_size(16),
+      max_size(4096),
+      size_param(1.5),
+      lifetime(LifetimeModel::LIFO),
+      mean_lifetime(1000.0),
+      max_live(1024),
+      phase_length(1000),
+      pattern(AddressPattern::SEQUENTIAL),
+      access_ratio(0.5),
+      stride(64),
+      zipf_theta(0.99) {}
+
+bool set_workload_option(WorkloadConfig& config, const std::string& option) {
+    size_t eq = option.find('=');
+    if (eq == std::string::npos)
+        return false;
+
+    std::string key = option.substr(0, eq);
+    std::string value = option.substr(eq + 1);
+
+    try {
+        if (key == "seed") config.seed = std::stoull(value);
+        else if (key == "ops") config.ops = std::stoull(value);
+        else if (key == "min") config.min_size = std::stoull(value);
+        else if (key == "max") config.max_size = std::stoull(value);
+        else if (key == "param") config.size_param = std::stod(value);
+        else if (key == "mean_life") config.mean_lifetime = std::stod(value);
+        else if (key == "max_live") config.max_live = std::stoull(value);
+        else if (key == "phase") config.phase_length = std::stoull(value);
+        else if (key == "access_ratio") config.access_ratio = std::stod(value);
+        else if (key == "stride") config.stride = std::stoull(value);
+        else if (key == "theta") config.zipf_theta = std::stod(value);
+        else if (key == "size") {
+            if (value == "uniform") config.size_dist = SizeDistribution::UNIFORM;
+            else if (value == "lognormal") config.size_dist = SizeDistribution::LOGNORMAL;
+            else if (value == "powerlaw") config.size_dist = SizeDistribution::POWER_LAW;
+            else if (value == "classes") config.size_dist = SizeDistribution::SIZE_CLASSES;
+            else return false;
+        }
+        else if (key == "lifetime") {
+            if (value == "lifo") config.lifetime = LifetimeModel::LIFO;
+            else if (value == "fifo") config.lifetime = LifetimeModel::FIFO;
+            else if (value == "exp") config.lifetime = LifetimeModel::EXPONENTIAL;
+            else if (value == "phase") config.lifetime = LifetimeModel::PHASE;
+            else return false;
+        }
+        else if (key == "access") {
+            if (value == "seq") config.pattern = AddressPattern::SEQUENTIAL;
+            else if (value == "stride") config.pattern = AddressPattern::STRIDED;
+            else if (value == "zipf") config.pattern = AddressPattern::ZIPF;
+            else if (value == "chase") config.pattern = AddressPattern::POINTER_CHASE;
+            else return false;
+        }
+        else return false;
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& cfg)
+    : config(cfg), zipf_alpha(0.0), zipf_eta(0.0), zipf_eta_n(0)
+{
+    if (config.min_size == 0) config.min_size = 1;
+    if (config.max_size < config.min_size) config.max_size = config.min_size;
+    if (config.max_live == 0) config.max_live = 1;
+    if (config.phase_length == 0) config.phase_length = 1;
+    if (config.stride == 0) config.stride = WORD_SIZE;
+
+    // Gray et al. constants; zeta is tabulated for every live count up to
+    // max_live so ranks are drawn over the blocks that actually exist
+    if (config.pattern == AddressPattern::ZIPF) {
+        double theta = config.zipf_theta;
+        if (theta == 1.0) theta = 0.9999;
+        config.zipf_theta = theta;
+
+        zipf_zeta.assign(config.max_live + 1, 0.0);
+        for (size_t i = 1; i <= config.max_live; ++i)
+            zipf_zeta[i] = zipf_zeta[i - 1] + 1.0 / std::pow(static_cast<double>(i), theta);
+
+        zipf_alpha = 1.0 / (1.0 - theta);
+    }
+
+    rewind();
+}
+
+void WorkloadGenerator::rewind() {
+    rng.seed(config.seed);
+    emitted = 0;
+    next_id = 1;
+
+    live.clear();
+    deaths = decltype(deaths)();
+    positions.clear();
+
+    growing = true;
+    phase_steps = 0;
+
+    cursor_block = 0;
+    cursor_offset = 0;
+    chase_id = 0;
+}
+
+double WorkloadGenerator::uniform01() {
+    return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+size_t WorkloadGenerator::sample_size() {
+    double lo = static_cast<double>(config.min_size);
+    double hi = static_cast<double>(config.max_size);
+    double size = lo;
+
+    switch (config.size_dist) {
+        case SizeDistribution::UNIFORM:
+            return config.min_size + rng() % (config.max_size - config.min_size + 1);
+
+        case SizeDistribution::LOGNORMAL: {
+            double mu = 0.5 * (std::log(lo) + std::log(hi));
+            std::normal_distribution<double> normal(0.0, 1.0);
+            size = std::exp(mu + config.size_param * normal(rng));
+            break;
+        }
+
+        case SizeDistribution::POWER_LAW: {
+            double alpha = config.size_param > 0 ? config.size_param : 1.5;
+            size = lo * std::pow(1.0 - uniform01(), -1.0 / alpha);
+            break;
+        }
+
+        case SizeDistribution::SIZE_CLASSES: {
+            int low_class = 0;
+            while ((1ULL << low_class) < config.min_size) low_class++;
+            int high_class = low_class;
+            while ((1ULL << (high_class + 1)) <= config.max_size) high_class++;
+            if ((1ULL << high_class) > config.max_size)
+                return config.min_size;
+            return 1ULL << (low_class + rng() % (high_class - low_class + 1));
+        }
+    }
+
+    size = std::min(std::max(size, lo), hi);
+    return static_cast<size_t>(size);
+}
+
+size_t WorkloadGenerator::sample_zipf(size_t n) {
+    double u = uniform01();
+    double uz = u * zipf_zeta[n];
+
+    if (uz < 1.0 || n == 1) return 0;
+    if (uz < 1.0 + std::pow(0.5, config.zipf_theta)) return 1;
+
+    // n > 2 here: with two ranks the branch above always returns
+    if (n != zipf_eta_n) {
+        double theta = config.zipf_theta;
+        zipf_eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) /
+                   (1.0 - zipf_zeta[2] / zipf_zeta[n]);
+        zipf_eta_n = n;
+    }
+
+    size_t rank = static_cast<size_t>(
+        n * std::pow(zipf_eta * u - zipf_eta + 1.0, zipf_alpha));
+    return std::min(rank, n - 1);
+}
+
+void WorkloadGenerator::emit_malloc(TraceOp& op) {
+    LiveBlock block = {next_id++, sample_size()};
+    live.push_back(block);
+
+    if (config.lifetime == LifetimeModel::EXPONENTIAL) {
+        std::exponential_distribution<double> life(1.0 / config.mean_lifetime);
+        uint64_t death = emitted + 1 + static_cast<uint64_t>(life(rng));
+        deaths.push({death, block.id});
+        positions[block.id] = live.size() - 1;
+    }
+
+    op = {TraceOpType::MALLOC, block.id, block.size};
+}
+
+void WorkloadGenerator::emit_free(size_t pos, TraceOp& op) {
+    op = {TraceOpType::FREE, live[pos].id, 0};
+
+    if (config.lifetime == LifetimeModel::EXPONENTIAL)
+        positions.erase(live[pos].id);
+
+    if (pos == 0 && config.lifetime == LifetimeModel::FIFO) {
+        live.pop_front();
+        return;
+    }
+
+    // swap-remove keeps every removal O(1)
+    if (pos != live.size() - 1) {
+        live[pos] = live.back();
+        if (config.lifetime == LifetimeModel::EXPONENTIAL)
+            positions[live[pos].id] = pos;
+    }
+    live.pop_back();
+}
+
+bool WorkloadGenerator::emit_access(TraceOp& op) {
+    size_t n = live.size();
+    if (n == 0)
+        return false;
+
+    const LiveBlock* block = nullptr;
+    size_t offset = 0;
+
+    switch (config.pattern) {
+        case AddressPattern::SEQUENTIAL:
+        case AddressPattern::STRIDED: {
+            size_t step = config.pattern == AddressPattern::SEQUENTIAL
+                              ? WORD_SIZE : config.stride;
+            cursor_block %= n;
+            if (cursor_offset >= live[cursor_block].size) {
+                cursor_block = (cursor_block + 1) % n;
+                cursor_offset = 0;
+            }
+            block = &live[cursor_block];
+            offset = cursor_offset;
+            cursor_offset += step;
+            break;
+        }
+
+        case AddressPattern::ZIPF:
+            block = &live[sample_zipf(n)];
+            offset = rng() % block->size;
+            break;
+
+        case AddressPattern::POINTER_CHASE: {
+            // the successor depends only on the current block, so the
+            // walk follows a fixed chain while the live set is stable
+            uint64_t h = mix64(chase_id ^ config.seed);
+            block = &live[h % n];
+            offset = ((h >> 32) % block->size) / WORD_SIZE * WORD_SIZE;
+            chase_id = block->id;
+            break;
+        }
+    }
+
+    op = {TraceOpType::ACCESS, block->id, offset};
+    return true;
+}
+
+bool WorkloadGenerator::next(TraceOp& op) {
+    if (emitted >= config.ops)
+        return false;
+
+    bool done = false;
+
+    // blocks whose lifetime ran out die first
+    if (config.lifetime == LifetimeModel::EXPONENTIAL &&
+        !deaths.empty() && deaths.top().first <= emitted) {
+        uint64_t id = deaths.top().second;
+        deaths.pop();
+        emit_free(positions[id], op);
+        done = true;
+    }
+
+    if (!done && config.access_ratio > 0 && uniform01() < config.access_ratio)
+        done = emit_access(op);
+
+    if (!done) {
+        bool full = live.size() >= config.max_live;
+        bool empty = live.empty();
+
+        switch (config.lifetime) {
+            case LifetimeModel::LIFO:
+            case LifetimeModel::FIFO:
+                if (empty || (!full && (rng() & 1)))
+                    emit_malloc(op);
+                else
+                    emit_free(config.lifetime == LifetimeModel::LIFO
+                                  ? live.size() - 1 : 0, op);
+                break;
+
+            case LifetimeModel::EXPONENTIAL:
+                if (!full) {
+                    emit_malloc(op);
+                } else {
+                    uint64_t id = deaths.top().second;
+                    deaths.pop();
+                    emit_free(positions[id], op);
+                }
+                break;
+
+            case LifetimeModel::PHASE:
+                if (++phase_steps >= config.phase_length) {
+                    growing = !growing;
+                    phase_steps = 0;
+                }
+                if (empty || (growing && !full))
+                    emit_malloc(op);
+                else
+                    emit_free(rng() % live.size(), op);
+                break;
+        }
+    }
+
+    emitted++;
+    return true;
+}
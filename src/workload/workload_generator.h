@@ -0,0 +1,116 @@
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include <deque>
+#include <queue>
+#include <vector>
+#include <string>
+#include <random>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "../trace/trace.h"
+
+enum class SizeDistribution {
+    UNIFORM,      // uniform in [min_size, max_size]
+    LOGNORMAL,    // median sqrt(min * max), sigma = size_param
+    POWER_LAW,    // Pareto from min_size, alpha = size_param
+    SIZE_CLASSES  // powers of two within [min_size, max_size]
+};
+
+enum class LifetimeModel {
+    LIFO,         // free the most recent allocation
+    FIFO,         // free the oldest allocation
+    EXPONENTIAL,  // each block dies after Exp(mean_lifetime) ops
+    PHASE         // alternate grow and teardown phases
+};
+
+enum class AddressPattern {
+    SEQUENTIAL,     // walk each live block word by word
+    STRIDED,        // walk live blocks in steps of `stride` bytes
+    ZIPF,           // zipfian choice of live block, random offset
+    POINTER_CHASE   // dependent hops between live blocks
+};
+
+struct WorkloadConfig {
+    uint64_t seed;
+    uint64_t ops;
+
+    SizeDistribution size_dist;
+    size_t min_size;
+    size_t max_size;
+    double size_param;
+
+    LifetimeModel lifetime;
+    double mean_lifetime;     // EXPONENTIAL, in ops
+    size_t max_live;          // bound on live blocks (and generator memory)
+    size_t phase_length;      // PHASE, alloc/free steps per phase
+
+    AddressPattern pattern;
+    double access_ratio;      // fraction of ops that are accesses
+    size_t stride;
+    double zipf_theta;
+
+    WorkloadConfig();
+};
+
+// apply a "key=value" option (seed, ops, size, min, max, param, lifetime,
+// mean_life, max_live, phase, access, access_ratio, stride, theta);
+// returns false for unknown keys or values
+bool set_workload_option(WorkloadConfig& config, const std::string& option);
+
+// deterministic, streaming workload: the same config always yields the
+// same ops, and memory use is bounded by max_live regardless of length
+class WorkloadGenerator : public TraceSource {
+private:
+    struct LiveBlock {
+        uint64_t id;
+        size_t size;
+    };
+
+    WorkloadConfig config;
+    std::mt19937_64 rng;
+
+    uint64_t emitted;
+    uint64_t next_id;
+
+    std::deque<LiveBlock> live;
+
+    // EXPONENTIAL: (death time, id) min-heap and id -> position in live
+    std::priority_queue<std::pair<uint64_t, uint64_t>,
+                        std::vector<std::pair<uint64_t, uint64_t>>,
+                        std::greater<std::pair<uint64_t, uint64_t>>> deaths;
+    std::unordered_map<uint64_t, size_t> positions;
+
+    // PHASE
+    bool growing;
+    size_t phase_steps;
+
+    // address stream state
+    size_t cursor_block;
+    size_t cursor_offset;
+    uint64_t chase_id;
+
+    // zipf over ranks [0, n) for the current live count n: zipf_zeta[n]
+    // is the prefix sum of 1/i^theta, eta is cached for the last n
+    std::vector<double> zipf_zeta;
+    double zipf_alpha;
+    double zipf_eta;
+    size_t zipf_eta_n;
+
+    size_t sample_size();
+    size_t sample_zipf(size_t n);
+    double uniform01();
+
+    void emit_malloc(TraceOp& op);
+    void emit_free(size_t pos, TraceOp& op);
+    bool emit_access(TraceOp& op);
+
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& config);
+
+    bool next(TraceOp& op) override;
+    void rewind() override;
+};
+
+#endif